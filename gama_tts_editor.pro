@@ -23,75 +23,109 @@ HEADERS += \
     src/Clipboard.h \
     src/DataEntryWindow.h \
     src/editor_global.h \
+    src/FormantTracker.h \
+    src/FrameRangeJob.h \
     src/interactive/AnalysisWindow.h \
     src/interactive/FFTW.h \
+    src/interactive/FFTWPlanner.h \
     src/interactive/InteractiveAudio.h \
     src/interactive/InteractiveVTMConfiguration.h \
     src/interactive/InteractiveVTMWindow.h \
+    src/interactive/MIDIControlMap.h \
+    src/interactive/MovingAverageFilterBank.h \
+    src/interactive/OutputLimiter.h \
     src/interactive/ParameterLineEdit.h \
     src/interactive/ParameterSlider.h \
+    src/interactive/ParameterTimeline.h \
+    src/interactive/SharedParameterTable.h \
     src/interactive/SignalDFT.h \
+    src/interactive/SpectrogramWidget.h \
+    src/interactive/SpectrumAverager.h \
+    src/interactive/SpectrumKernels.h \
+    src/interactive/TimelineRenderer.h \
+    src/interactive/VoiceRenderer.h \
+    src/interactive/VTMBenchmark.h \
     src/IntonationParametersWindow.h \
     src/IntonationWidget.h \
     src/IntonationWindow.h \
     src/JackClient.h \
-    src/JackRingbuffer.h \
     src/MainWindow.h \
     src/ParameterModificationSynthesis.h \
     src/ParameterModificationWidget.h \
     src/ParameterModificationWindow.h \
     src/ParameterWidget.h \
+    src/PitchTracker.h \
     src/PostureEditorWindow.h \
     src/PrototypeManagerWindow.h \
     src/qcustomplot/qcustomplot.h \
     src/qt_model/CategoryModel.h \
     src/qt_model/ParameterModel.h \
     src/qt_model/SymbolModel.h \
+    src/RealtimeLog.h \
     src/RuleManagerWindow.h \
     src/RuleTesterWindow.h \
+    src/SpeechSpectrogram.h \
+    src/SPSCQueue.h \
     src/Synthesis.h \
     src/SynthesisWindow.h \
     src/TransitionEditorWindow.h \
     src/TransitionPoint.h \
-    src/TransitionWidget.h
+    src/TransitionWidget.h \
+    src/VocalTractModelPool.h
 
 SOURCES += \
     src/AudioPlayer.cpp \
     src/AudioWorker.cpp \
     src/Clipboard.cpp \
     src/DataEntryWindow.cpp \
+    src/FormantTracker.cpp \
     src/interactive/AnalysisWindow.cpp \
     src/interactive/FFTW.cpp \
+    src/interactive/FFTWPlanner.cpp \
     src/interactive/InteractiveAudio.cpp \
     src/interactive/InteractiveVTMConfiguration.cpp \
     src/interactive/InteractiveVTMWindow.cpp \
+    src/interactive/MIDIControlMap.cpp \
+    src/interactive/MovingAverageFilterBank.cpp \
+    src/interactive/OutputLimiter.cpp \
     src/interactive/ParameterLineEdit.cpp \
     src/interactive/ParameterSlider.cpp \
+    src/interactive/ParameterTimeline.cpp \
+    src/interactive/SharedParameterTable.cpp \
     src/interactive/SignalDFT.cpp \
+    src/interactive/SpectrogramWidget.cpp \
+    src/interactive/SpectrumAverager.cpp \
+    src/interactive/SpectrumKernels.cpp \
+    src/interactive/TimelineRenderer.cpp \
+    src/interactive/VoiceRenderer.cpp \
+    src/interactive/VTMBenchmark.cpp \
     src/IntonationParametersWindow.cpp \
     src/IntonationWidget.cpp \
     src/IntonationWindow.cpp \
     src/JackClient.cpp \
-    src/JackRingbuffer.cpp \
     src/main.cpp \
     src/MainWindow.cpp \
     src/ParameterModificationSynthesis.cpp \
     src/ParameterModificationWidget.cpp \
     src/ParameterModificationWindow.cpp \
     src/ParameterWidget.cpp \
+    src/PitchTracker.cpp \
     src/PostureEditorWindow.cpp \
     src/PrototypeManagerWindow.cpp \
     src/qcustomplot/qcustomplot.cpp \
     src/qt_model/CategoryModel.cpp \
     src/qt_model/ParameterModel.cpp \
     src/qt_model/SymbolModel.cpp \
+    src/RealtimeLog.cpp \
     src/RuleManagerWindow.cpp \
     src/RuleTesterWindow.cpp \
+    src/SpeechSpectrogram.cpp \
     src/Synthesis.cpp \
     src/SynthesisWindow.cpp \
     src/TransitionEditorWindow.cpp \
     src/TransitionPoint.cpp \
-    src/TransitionWidget.cpp
+    src/TransitionWidget.cpp \
+    src/VocalTractModelPool.cpp
 
 FORMS += \
     ui/DataEntryWindow.ui \
@@ -18,13 +18,12 @@
 #include "AudioPlayer.h"
 
 #include <chrono>
-#include <iostream>
 #include <memory>
 #include <thread>
 
 #include "Exception.h"
 #include "JackClient.h"
-#include "Log.h"
+#include "RealtimeLog.h"
 
 
 
@@ -55,7 +54,7 @@ player_jack_process_callback(jack_nframes_t nframes, void* arg)
 void
 player_jack_shutdown_callback(void* arg)
 {
-	if (Log::debugEnabled) std::cout << "[AudioPlayer] player_jack_shutdown_callback()" << std::endl;
+	RealtimeLog::post(RealtimeLog::LEVEL_DEBUG, "AudioPlayer", "player_jack_shutdown_callback()");
 
 	static_cast<AudioPlayer*>(arg)->stop();
 }
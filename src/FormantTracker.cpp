@@ -0,0 +1,305 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "FormantTracker.h"
+
+#include <algorithm> /* max, min, sort */
+#include <cmath> /* cos, floor, log, pow, rint, sin, sqrt */
+#include <complex>
+#include <memory>
+#include <utility> /* move */
+
+#include "SpectrumKernels.h"
+
+#define MIN_ANALYSIS_RATE (10000.0)
+#define FILTER_TAPS_PER_FACTOR (16U)
+#define FILTER_CUTOFF (0.45) // relative to the analysis sample rate
+#define WINDOW_DURATION_MS (25.0)
+#define HOP_DURATION_MS (5.0)
+#define PRE_EMPHASIS (0.97)
+#define SILENCE_DB (-40.0) // relative to the peak of the signal
+#define WHITE_NOISE_CORRECTION (1.0e-4)
+#define MIN_FORMANT_FREQ (90.0)
+#define MAX_FORMANT_BANDWIDTH (500.0)
+#define ROOT_MAX_ITERATIONS (200U)
+#define ROOT_TOLERANCE (1.0e-10)
+
+
+
+namespace {
+
+// Levinson-Durbin recursion.
+// r: autocorrelation [0..order].
+// a: prediction coefficients [0..order], with a[0] = 1.
+// Returns false if the filter is not stable.
+bool
+levinsonDurbin(const std::vector<double>& r, std::vector<double>& a, std::vector<double>& temp)
+{
+	const unsigned int order = r.size() - 1U;
+	a.assign(order + 1U, 0.0);
+	a[0] = 1.0;
+	double error = r[0];
+	if (error <= 0.0) return false;
+
+	for (unsigned int i = 1; i <= order; ++i) {
+		double acc = r[i];
+		for (unsigned int j = 1; j < i; ++j) {
+			acc += a[j] * r[i - j];
+		}
+		const double k = -acc / error;
+		temp.assign(a.begin(), a.end());
+		for (unsigned int j = 1; j < i; ++j) {
+			a[j] = temp[j] + k * temp[i - j];
+		}
+		a[i] = k;
+		error *= 1.0 - k * k;
+		if (error <= 0.0) return false;
+	}
+	return true;
+}
+
+// Durand-Kerner method.
+// coef: polynomial coefficients, from the highest degree. coef[0] must be 1.
+void
+findRoots(const std::vector<double>& coef, std::vector<std::complex<double>>& roots)
+{
+	const unsigned int n = coef.size() - 1U;
+	roots.resize(n);
+	const std::complex<double> seed{0.4, 0.9};
+	std::complex<double> z{1.0, 0.0};
+	for (unsigned int i = 0; i < n; ++i) {
+		roots[i] = z;
+		z *= seed;
+	}
+
+	for (unsigned int iter = 0; iter < ROOT_MAX_ITERATIONS; ++iter) {
+		double maxDelta = 0.0;
+		for (unsigned int i = 0; i < n; ++i) {
+			const std::complex<double> x = roots[i];
+			std::complex<double> value{coef[0], 0.0};
+			for (unsigned int k = 1; k <= n; ++k) {
+				value = value * x + coef[k];
+			}
+			std::complex<double> denom{1.0, 0.0};
+			for (unsigned int j = 0; j < n; ++j) {
+				if (j != i) denom *= x - roots[j];
+			}
+			if (std::abs(denom) == 0.0) {
+				denom = ROOT_TOLERANCE;
+			}
+			const std::complex<double> delta = value / denom;
+			roots[i] -= delta;
+			maxDelta = std::max(maxDelta, std::abs(delta));
+		}
+		if (maxDelta < ROOT_TOLERANCE) break;
+	}
+}
+
+} /* namespace */
+
+namespace GS {
+
+struct FormantTracker::Analysis {
+	std::vector<float> signal;
+	double sampleRate;
+	unsigned int decimationFactor;
+	double analysisRate;
+	std::vector<double> filter; // low-pass, for the decimation
+	unsigned int decimatedSize;
+	unsigned int windowSize;
+	unsigned int hopSize;
+	unsigned int order;
+	unsigned int numFrames;
+	double frameDuration;
+	double silenceLevel; // RMS
+	std::vector<float> formantList; // Hz, [frame * NUM_FORMANTS + index]
+
+	// Returns the sample of the decimated signal.
+	double decimatedSample(long index) const;
+};
+
+double
+FormantTracker::Analysis::decimatedSample(long index) const
+{
+	if (index < 0 || index >= static_cast<long>(decimatedSize)) return 0.0;
+
+	const long signalSize = signal.size();
+	const long first = index * decimationFactor - static_cast<long>(filter.size() / 2U);
+	double sum = 0.0;
+	for (long k = std::max(0L, -first), size = filter.size(); k < size && first + k < signalSize; ++k) {
+		sum += filter[k] * signal[first + k];
+	}
+	return sum;
+}
+
+// Called by the tasks of the job.
+void
+FormantTracker::analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+				const std::atomic<bool>& canceled)
+{
+	std::vector<double> window(analysis.windowSize);
+	const double coef = 2.0 * M_PI / (analysis.windowSize - 1);
+	for (unsigned int i = 0; i < analysis.windowSize; ++i) {
+		window[i] = 0.54 - 0.46 * std::cos(coef * i); // Hamming
+	}
+	std::vector<double> samples(analysis.windowSize + 1U);
+	std::vector<double> frame(analysis.windowSize);
+	std::vector<double> r(analysis.order + 1U);
+	std::vector<double> a, temp;
+	std::vector<std::complex<double>> roots;
+	std::vector<double> freqList;
+	freqList.reserve(analysis.order);
+
+	for (unsigned int f = firstFrame; f < endFrame && !canceled; ++f) {
+		// The window is centered in the frame.
+		// One more sample is needed for the pre-emphasis.
+		const long start = static_cast<long>(f) * analysis.hopSize + analysis.hopSize / 2 - analysis.windowSize / 2 - 1;
+		double energy = 0.0;
+		for (unsigned int i = 0; i <= analysis.windowSize; ++i) {
+			samples[i] = analysis.decimatedSample(start + i);
+			energy += samples[i] * samples[i];
+		}
+		if (std::sqrt(energy / (analysis.windowSize + 1U)) < analysis.silenceLevel) {
+			continue;
+		}
+		for (unsigned int i = 0; i < analysis.windowSize; ++i) {
+			frame[i] = (samples[i + 1U] - PRE_EMPHASIS * samples[i]) * window[i];
+		}
+
+		for (unsigned int lag = 0; lag <= analysis.order; ++lag) {
+			double sum = 0.0;
+			for (unsigned int i = lag; i < analysis.windowSize; ++i) {
+				sum += frame[i] * frame[i - lag];
+			}
+			r[lag] = sum;
+		}
+		r[0] *= 1.0 + WHITE_NOISE_CORRECTION;
+		if (!levinsonDurbin(r, a, temp)) {
+			continue;
+		}
+
+		// The formants are the complex roots with narrow bandwidth.
+		findRoots(a, roots);
+		freqList.clear();
+		for (const auto& z : roots) {
+			if (z.imag() <= 0.0) continue;
+			const double freq = std::arg(z) * analysis.analysisRate / (2.0 * M_PI);
+			const double bandwidth = -std::log(std::abs(z)) * analysis.analysisRate / M_PI;
+			if (freq > MIN_FORMANT_FREQ && freq < 0.5 * analysis.analysisRate - MIN_FORMANT_FREQ &&
+					bandwidth < MAX_FORMANT_BANDWIDTH) {
+				freqList.push_back(freq);
+			}
+		}
+		std::sort(freqList.begin(), freqList.end());
+		float* formants = &analysis.formantList[static_cast<std::size_t>(f) * NUM_FORMANTS];
+		for (unsigned int i = 0, n = std::min<unsigned int>(freqList.size(), NUM_FORMANTS); i < n; ++i) {
+			formants[i] = freqList[i];
+		}
+	}
+}
+
+FormantTracker::FormantTracker(QObject* parent)
+		: QObject{parent}
+{
+}
+
+FormantTracker::~FormantTracker()
+{
+}
+
+void
+FormantTracker::compute(const std::vector<float>& signal, double sampleRate)
+{
+	const Analysis* prevAnalysis = job_.data();
+	if (prevAnalysis && prevAnalysis->sampleRate == sampleRate && prevAnalysis->signal == signal) {
+		return; // already computed
+	}
+
+	clear();
+	if (signal.empty() || sampleRate <= 0.0) return;
+
+	auto analysis = std::make_unique<Analysis>();
+	analysis->signal = signal;
+	analysis->sampleRate = sampleRate;
+	analysis->decimationFactor = std::max(static_cast<unsigned int>(std::floor(sampleRate / MIN_ANALYSIS_RATE)), 1U);
+	analysis->analysisRate = sampleRate / analysis->decimationFactor;
+	if (analysis->decimationFactor == 1U) {
+		analysis->filter.assign(1, 1.0);
+	} else {
+		// Windowed sinc.
+		const unsigned int numTaps = FILTER_TAPS_PER_FACTOR * analysis->decimationFactor + 1U;
+		const double cutoff = FILTER_CUTOFF / analysis->decimationFactor; // cycles / sample
+		const double center = (numTaps - 1U) / 2.0;
+		const double coef = 2.0 * M_PI / (numTaps - 1U);
+		analysis->filter.resize(numTaps);
+		double sum = 0.0;
+		for (unsigned int i = 0; i < numTaps; ++i) {
+			const double x = i - center;
+			const double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+			analysis->filter[i] = sinc * (0.54 - 0.46 * std::cos(coef * i)); // Hamming
+			sum += analysis->filter[i];
+		}
+		for (double& value : analysis->filter) {
+			value /= sum;
+		}
+	}
+	analysis->decimatedSize = (signal.size() + analysis->decimationFactor - 1U) / analysis->decimationFactor;
+	analysis->windowSize = std::max(static_cast<unsigned int>(std::rint(WINDOW_DURATION_MS * 1.0e-3 * analysis->analysisRate)), 2U);
+	analysis->hopSize = std::max(static_cast<unsigned int>(std::rint(HOP_DURATION_MS * 1.0e-3 * analysis->analysisRate)), 1U);
+	analysis->order = 2U + static_cast<unsigned int>(std::rint(analysis->analysisRate / 1000.0));
+	analysis->numFrames = (analysis->decimatedSize + analysis->hopSize - 1U) / analysis->hopSize;
+	analysis->frameDuration = 1000.0 * analysis->hopSize / analysis->analysisRate;
+	analysis->silenceLevel = SpectrumKernels::maxAbs(&signal[0], signal.size()) * std::pow(10.0, SILENCE_DB / 20.0);
+	analysis->formantList.assign(static_cast<std::size_t>(analysis->numFrames) * NUM_FORMANTS, 0.0f);
+
+	const unsigned int numFrames = analysis->numFrames;
+	job_.start(std::move(analysis), numFrames, &FormantTracker::analyzeFrames, nullptr,
+			[this]() { emit finished(); });
+}
+
+void
+FormantTracker::clear()
+{
+	job_.cancel();
+}
+
+bool
+FormantTracker::ready() const
+{
+	return job_.ready();
+}
+
+double
+FormantTracker::frameDuration() const
+{
+	return job_.data()->frameDuration;
+}
+
+unsigned int
+FormantTracker::numFrames() const
+{
+	return job_.data()->numFrames;
+}
+
+float
+FormantTracker::formant(unsigned int frame, unsigned int index) const
+{
+	return job_.data()->formantList[static_cast<std::size_t>(frame) * NUM_FORMANTS + index];
+}
+
+} // namespace GS
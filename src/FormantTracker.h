@@ -0,0 +1,79 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef FORMANT_TRACKER_H
+#define FORMANT_TRACKER_H
+
+#include <atomic>
+#include <vector>
+
+#include <QObject>
+
+#include "FrameRangeJob.h"
+
+
+
+namespace GS {
+
+// Estimates the formant frequencies of a synthesized utterance.
+//
+// The signal is decimated to about 11 kHz, and each frame is analyzed by
+// LPC (autocorrelation method, Levinson-Durbin recursion). The formants are
+// obtained from the roots of the prediction polynomial.
+//
+// The results are kept until a different signal is passed to compute().
+class FormantTracker : public QObject {
+	Q_OBJECT
+public:
+	enum {
+		NUM_FORMANTS = 4
+	};
+
+	explicit FormantTracker(QObject* parent=nullptr);
+	virtual ~FormantTracker();
+
+	// Starts the computation. Cancels the previous computation.
+	// Does nothing if the signal and the sample rate have not changed.
+	void compute(const std::vector<float>& signal, double sampleRate);
+	void clear();
+
+	// The functions below must be called only if ready() returns true.
+	bool ready() const;
+	double frameDuration() const; // ms
+	unsigned int numFrames() const;
+	// Returns the frequency (Hz) of the formant (0: F1) in the frame,
+	// or 0.0 if it was not found.
+	float formant(unsigned int frame, unsigned int index) const;
+signals:
+	// Emitted from a thread of the pool.
+	void finished();
+private:
+	struct Analysis;
+
+	FormantTracker(const FormantTracker&) = delete;
+	FormantTracker& operator=(const FormantTracker&) = delete;
+
+	static void analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+					const std::atomic<bool>& canceled);
+
+	FrameRangeJob<Analysis> job_;
+};
+
+} // namespace GS
+
+#endif // FORMANT_TRACKER_H
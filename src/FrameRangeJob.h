@@ -0,0 +1,191 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+
+#ifndef FRAME_RANGE_JOB_H
+#define FRAME_RANGE_JOB_H
+
+#include <algorithm> /* max, min */
+#include <atomic>
+#include <cstddef> /* std::size_t */
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <utility> /* move */
+
+#include <QRunnable>
+#include <QThreadPool>
+
+
+
+namespace GS {
+
+// Analysis of a sequence of frames in the global QThreadPool, each task
+// processing a range of frames.
+//
+// The data of the analysis (T) is shared by the tasks and is destroyed by
+// the last owner. So cancel() does not wait for the tasks, they only stop
+// at the next frame.
+template<typename T>
+class FrameRangeJob {
+public:
+	// Called by the tasks. Must check canceled after each frame.
+	typedef std::function<void (T& data, unsigned int firstFrame, unsigned int endFrame,
+					const std::atomic<bool>& canceled)> RangeFunction;
+	// Called by the last task, if the job has not been canceled.
+	typedef std::function<void (T& data)> FinishFunction;
+	// Called by the last task after finish, if cancel() has not been called.
+	typedef std::function<void ()> NotifyFunction;
+
+	FrameRangeJob() = default;
+	~FrameRangeJob() { cancel(); }
+
+	// Cancels the previous job. finish may be empty.
+	void start(std::unique_ptr<T> data, unsigned int numFrames,
+			RangeFunction processRange, FinishFunction finish, NotifyFunction notify);
+	// Does not wait for the tasks. After the return, notify will not be called.
+	void cancel();
+
+	// Returns true if the job has finished without errors.
+	bool ready() const { return state_ && state_->done; }
+	// Returns null if there is no job, or if it has failed.
+	// The results can be read only if ready() returns true.
+	const T* data() const { return (state_ && !state_->canceled) ? state_->data.get() : nullptr; }
+private:
+	struct State {
+		std::unique_ptr<T> data;
+		RangeFunction processRange;
+		FinishFunction finish;
+		NotifyFunction notify;
+		std::atomic<bool> canceled;
+		std::atomic<bool> done;
+		std::atomic<unsigned int> pendingTasks;
+		std::mutex notifyMutex;
+	};
+	class Task;
+
+	FrameRangeJob(const FrameRangeJob&) = delete;
+	FrameRangeJob& operator=(const FrameRangeJob&) = delete;
+
+	static void finishTask(State& state);
+
+	std::shared_ptr<State> state_;
+};
+
+template<typename T>
+class FrameRangeJob<T>::Task : public QRunnable {
+public:
+	Task(std::shared_ptr<State> state, unsigned int firstFrame, unsigned int endFrame)
+			: state_{std::move(state)}
+			, firstFrame_{firstFrame}
+			, endFrame_{endFrame} {}
+	virtual ~Task() {}
+	virtual void run();
+private:
+	std::shared_ptr<State> state_;
+	const unsigned int firstFrame_;
+	const unsigned int endFrame_;
+};
+
+template<typename T>
+void
+FrameRangeJob<T>::Task::run()
+{
+	State& state = *state_;
+	try {
+		state.processRange(*state.data, firstFrame_, endFrame_, state.canceled);
+	} catch (std::exception& exc) {
+		std::cerr << "[FrameRangeJob::Task::run] Caught exception: " << exc.what() << '.' << std::endl;
+		state.canceled = true;
+	}
+	finishTask(state);
+}
+
+template<typename T>
+void
+FrameRangeJob<T>::start(std::unique_ptr<T> data, unsigned int numFrames,
+			RangeFunction processRange, FinishFunction finish, NotifyFunction notify)
+{
+	cancel();
+
+	auto state = std::make_shared<State>();
+	state->data = std::move(data);
+	state->processRange = std::move(processRange);
+	state->finish = std::move(finish);
+	state->notify = std::move(notify);
+	state->canceled = false;
+	state->done = false;
+
+	QThreadPool* pool = QThreadPool::globalInstance();
+	const unsigned int numTasks = std::min(numFrames, static_cast<unsigned int>(std::max(pool->maxThreadCount(), 1)));
+	state->pendingTasks = numTasks;
+	state_ = state;
+	if (numTasks == 0) {
+		state->pendingTasks = 1;
+		finishTask(*state);
+		return;
+	}
+	for (unsigned int i = 0; i < numTasks; ++i) {
+		const unsigned int firstFrame = static_cast<std::size_t>(numFrames) * i / numTasks;
+		const unsigned int endFrame   = static_cast<std::size_t>(numFrames) * (i + 1U) / numTasks;
+		pool->start(new Task(state, firstFrame, endFrame));
+	}
+}
+
+template<typename T>
+void
+FrameRangeJob<T>::cancel()
+{
+	if (!state_) return;
+
+	{
+		// Waits only if notify is being called.
+		std::lock_guard<std::mutex> lock(state_->notifyMutex);
+		state_->canceled = true;
+	}
+	state_.reset();
+}
+
+// Called by each task at the end.
+template<typename T>
+void
+FrameRangeJob<T>::finishTask(State& state)
+{
+	if (--state.pendingTasks > 0 || state.canceled) return;
+
+	if (state.finish) {
+		try {
+			state.finish(*state.data);
+		} catch (std::exception& exc) {
+			std::cerr << "[FrameRangeJob::finishTask] Caught exception: " << exc.what() << '.' << std::endl;
+			state.canceled = true;
+			return;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(state.notifyMutex);
+	if (state.canceled) return;
+	state.done = true;
+	state.notify();
+}
+
+} // namespace GS
+
+#endif // FRAME_RANGE_JOB_H
@@ -21,12 +21,13 @@
 #include "IntonationWidget.h"
 
 #include <algorithm> /* max, min */
-#include <cmath> /* abs */
+#include <cmath> /* abs, log2 */
 
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPointF>
+#include <QPolygonF>
 #include <QRectF>
 #include <QSizePolicy>
 
@@ -48,6 +49,7 @@
 #define MARKER_SIZE 3.5
 #define SMOOTH_POINTS_X_INCREMENT 5
 #define TIME_DIVISION_MARK_SIZE 5
+#define GLOTTAL_PITCH_REF_FREQ 261.6256 // Hz, glottal pitch 0 (middle C)
 
 
 
@@ -94,6 +96,8 @@ IntonationWidget::IntonationWidget(QWidget* parent)
 	setMinimumHeight(totalHeight_);
 
 	setFocusPolicy(Qt::StrongFocus); // enable key events
+
+	connect(&pitchTracker_, &PitchTracker::finished, this, [this]() { update(); });
 }
 
 // Note: with no antialiasing, the coordinates in QPointF are rounded to the nearest integer.
@@ -236,6 +240,29 @@ IntonationWidget::paintEvent(QPaintEvent*)
 	painter.setBrush(QBrush{});
 
 	smoothPoints(painter);
+
+	// Measured pitch.
+	if (pitchTracker_.ready()) {
+		painter.save();
+		painter.setClipRect(QRectF(QPointF(xStart, yEnd), QPointF(xEnd, yStart)));
+		painter.setPen(Qt::red);
+		const double frameDuration = pitchTracker_.frameDuration();
+		const double pitchMean = eventList_->pitchMean();
+		QPolygonF line;
+		for (unsigned int i = 0, numFrames = pitchTracker_.numFrames(); i <= numFrames; ++i) {
+			const double f0 = (i < numFrames) ? pitchTracker_.f0(i) : 0.0;
+			if (f0 > 0.0) {
+				const double value = 12.0 * std::log2(f0 / GLOTTAL_PITCH_REF_FREQ) - pitchMean;
+				line.append(QPointF(0.5 + timeToX((i + 0.5) * frameDuration), 0.5 + valueToY(value)));
+			} else if (!line.isEmpty()) {
+				// Unvoiced frame.
+				painter.drawPolyline(line);
+				line.clear();
+			}
+		}
+		painter.restore();
+	}
+
 	painter.setPen(pen);
 
 	painter.setRenderHint(QPainter::Antialiasing, false);
@@ -406,6 +433,16 @@ IntonationWidget::updateData(VTMControlModel::EventList* eventList)
 
 	modelUpdated_ = true;
 
+	pitchTracker_.clear();
+
+	update();
+}
+
+void
+IntonationWidget::updateSpeechSignal(const std::vector<float>& signal, double sampleRate)
+{
+	pitchTracker_.compute(signal, sampleRate);
+
 	update();
 }
 
@@ -491,6 +528,7 @@ IntonationWidget::loadIntonationFromEventList()
 	graphWidth_ = maxTime_ * timeScale_;
 
 	intonationPointList_ = eventList_->intonationPoints();
+	pitchTracker_.clear(); // the speech signal is from the previous text
 	if (selectedPoint_ >= static_cast<int>(intonationPointList_.size())) {
 		selectedPoint_ = -1;
 	}
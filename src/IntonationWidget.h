@@ -26,6 +26,7 @@
 #include <QWidget>
 
 #include "IntonationPoint.h"
+#include "PitchTracker.h"
 
 
 
@@ -42,6 +43,8 @@ public:
 
 	virtual QSize sizeHint() const;
 	void updateData(VTMControlModel::EventList* eventList);
+	// Analyzes the pitch of the speech synthesized from the event list.
+	void updateSpeechSignal(const std::vector<float>& signal, double sampleRate);
 	void setSelectedPointValue(double value);
 	void setSelectedPointSlope(double slope);
 	void setSelectedPointBeatOffset(double beatOffset);
@@ -83,6 +86,7 @@ private:
 	int selectedPoint_;
 	std::vector<VTMControlModel::IntonationPoint> intonationPointList_;
 	std::vector<int> postureTimeList_;
+	PitchTracker pitchTracker_;
 };
 
 } // namespace GS
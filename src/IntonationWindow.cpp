@@ -111,6 +111,13 @@ IntonationWindow::loadIntonationFromEventList()
 	ui_->intonationWidget->loadIntonationFromEventList();
 }
 
+// Slot.
+void
+IntonationWindow::updateSpeechSignal(const std::vector<float>& signal, double sampleRate)
+{
+	ui_->intonationWidget->updateSpeechSignal(signal, sampleRate);
+}
+
 void
 IntonationWindow::on_valueLineEdit_editingFinished()
 {
@@ -19,6 +19,7 @@
 #define INTONATION_WINDOW_H
 
 #include <memory>
+#include <vector>
 
 #include <QWidget>
 
@@ -45,6 +46,7 @@ public slots:
 	void on_synthesizeButton_clicked();
 	void on_synthesizeToFileButton_clicked();
 	void loadIntonationFromEventList();
+	void updateSpeechSignal(const std::vector<float>& signal, double sampleRate);
 	void enableProcessingButtons();
 	void disableProcessingButtons();
 private slots:
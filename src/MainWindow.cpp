@@ -162,6 +162,9 @@ MainWindow::MainWindow(QWidget* parent)
 	connect(synthesisWindow_.get() , &SynthesisWindow::textSynthesized,
 			parameterModificationWindow_.get(), &ParameterModificationWindow::resetData);
 
+	connect(synthesisWindow_.get() , &SynthesisWindow::speechSignalUpdated,
+			intonationWindow_.get()           , &IntonationWindow::updateSpeechSignal);
+
 	connect(synthesisWindow_.get() , &SynthesisWindow::synthesisStarted,
 			intonationWindow_.get()           , &IntonationWindow::disableProcessingButtons);
 	connect(synthesisWindow_.get() , &SynthesisWindow::synthesisStarted,
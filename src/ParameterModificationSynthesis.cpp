@@ -17,6 +17,7 @@
 
 #include "ParameterModificationSynthesis.h"
 
+#include <cassert>
 #include <chrono>
 #include <cmath> /* rint */
 #include <iostream>
@@ -25,6 +26,7 @@
 #include "ConfigurationData.h"
 #include "Exception.h"
 #include "Log.h"
+#include "RealtimeLog.h"
 #include "VocalTractModel.h"
 #include "VTMUtil.h"
 
@@ -51,7 +53,7 @@ param_modif_jack_process_callback(jack_nframes_t nframes, void* arg)
 		ParameterModificationSynthesis::Processor* p = static_cast<ParameterModificationSynthesis::Processor*>(arg);
 		return p->process(nframes);
 	} catch (std::exception& exc) {
-		std::cerr << "[ParameterModificationSynthesis/jack_process_callback] Caught exception: " << exc.what() << '.' << std::endl;
+		RealtimeLog::post(RealtimeLog::LEVEL_ERROR, "ParameterModificationSynthesis/jack_process_callback", exc.what());
 		return 1;
 	}
 }
@@ -63,7 +65,7 @@ param_modif_jack_process_callback(jack_nframes_t nframes, void* arg)
 void
 param_modif_jack_shutdown_callback(void* arg)
 {
-	if (Log::debugEnabled) std::cout << "[ParameterModificationSynthesis] jack_shutdown_callback()" << std::endl;
+	RealtimeLog::post(RealtimeLog::LEVEL_DEBUG, "ParameterModificationSynthesis", "jack_shutdown_callback()");
 
 	ParameterModificationSynthesis::Processor* p = static_cast<ParameterModificationSynthesis::Processor*>(arg);
 	p->stop();
@@ -82,13 +84,21 @@ namespace GS {
  */
 ParameterModificationSynthesis::Processor::Processor(
 			unsigned int numberOfParameters,
-			JackRingbuffer* parameterRingbuffer,
+			ModificationQueue* modificationQueue,
 			const ConfigurationData& vtmConfigData,
 			double controlRate)
 		: numParameters_{numberOfParameters}
 		, outputPort_{}
 		, vtmBufferPos_{}
-		, parameterRingbuffer_{parameterRingbuffer}
+		, modificationQueue_{modificationQueue}
+		, audioQueue_{}
+		, lookaheadSamples_{}
+		, renderThreadRunning_{}
+		, renderFinished_{}
+		, underflowCount_{}
+		, modifiedRangeQueue_{std::make_unique<SPSCQueue<ModifiedRange>>(MODIFIED_RANGE_QUEUE_SIZE)}
+		, pendingModifiedRange_{}
+		, pendingModifiedRangeValid_{}
 		, vocalTractModel_{VTM::VocalTractModel::getInstance(vtmConfigData, false)}
 		, currentParam_(numParameters_)
 		, delta_(numParameters_)
@@ -98,8 +108,8 @@ ParameterModificationSynthesis::Processor::Processor(
 		, controlSteps_{static_cast<unsigned int>(std::rint(vocalTractModel_->internalSampleRate() / controlRate))}
 		, modifFilter_{static_cast<float>(vocalTractModel_->internalSampleRate()), PARAMETER_FILTER_PERIOD_SEC}
 {
-	if (!parameterRingbuffer_) {
-		THROW_EXCEPTION(MissingValueException, "Missing parameter ringbuffer.");
+	if (!modificationQueue_) {
+		THROW_EXCEPTION(MissingValueException, "Missing modification queue.");
 	}
 
 	modif_.clear();
@@ -110,6 +120,7 @@ ParameterModificationSynthesis::Processor::Processor(
  */
 ParameterModificationSynthesis::Processor::~Processor()
 {
+	stopRendering();
 }
 
 /*******************************************************************************
@@ -120,70 +131,190 @@ ParameterModificationSynthesis::Processor::process(jack_nframes_t nframes)
 {
 	if (!outputPort_) return 1; // end
 	jack_default_audio_sample_t* out = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(outputPort_, nframes));
-	std::vector<float>& vtmOutputBuffer = vocalTractModel_->outputBuffer();
 
-	const std::size_t n = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out,
-							nframes, gain_);
+	// Must be read before the queue.
+	const bool renderFinished = renderFinished_;
 
-	if (n == nframes) return 0; // JACK does not need more samples
+	const std::size_t n = audioQueue_->pop(out, nframes);
+	if (n == nframes) return 0;
 
-	// JACK needs more samples.
+	for (std::size_t i = n; i < nframes; ++i) {
+		out[i] = 0.0;
+	}
+	if (renderFinished) {
+		return 1; // end
+	}
 
-	const std::size_t targetBufferSize = nframes - n;
-	while (vtmOutputBuffer.size() < targetBufferSize) { // while there is not enough data available
-		if (paramSetIndex_ >= modifiedParamList_.size()) {
-			return 1; // end
-		}
+	// The render thread is late.
+	++underflowCount_;
+	return 0;
+}
 
-		// Get modification data.
-		if (parameterRingbuffer_->readSpace() >= sizeof(Modification)) {
-#ifndef NDEBUG
-			size_t bytesRead =
-#endif
-			parameterRingbuffer_->read(reinterpret_cast<char*>(&modif_), sizeof(Modification));
-			assert(bytesRead == sizeof(Modification));
-			assert(modif_.parameter < numParameters_);
+/*******************************************************************************
+ * Render thread.
+ */
+void
+ParameterModificationSynthesis::Processor::render()
+{
+	try {
+		while (renderThreadRunning_) {
+			const bool dataAvailable = fillAudioQueue();
+			publishModifiedRange();
+			if (!dataAvailable) {
+				renderFinished_ = true;
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(RENDER_THREAD_SLEEP_US));
 		}
+	} catch (std::exception& exc) {
+		std::cerr << "[ParameterModificationSynthesis::Processor::render] Caught exception: " << exc.what() << '.' << std::endl;
+		renderFinished_ = true;
+	}
+}
 
-		const float filteredModif = (modif_.operation != OPER_NONE) ? modifFilter_.filter(modif_.value) : 0.0;
+/*******************************************************************************
+ * Runs the vocal tract model until the audio queue holds
+ * lookaheadSamples_ samples.
+ *
+ * The samples are written directly in the queue.
+ *
+ * Returns false when there are no more data to process.
+ */
+bool
+ParameterModificationSynthesis::Processor::fillAudioQueue()
+{
+	std::vector<float>& vtmOutputBuffer = vocalTractModel_->outputBuffer();
 
-		// Calculate the parameters for the control step.
-		if (stepIndex_ == 0) {
-			// Apply the modification.
-			const float origValue = paramList_[paramSetIndex_][modif_.parameter];
-			if (modif_.operation == OPER_ADD) {
-				modifiedParamList_[paramSetIndex_][modif_.parameter] = origValue + filteredModif;
-			} else if (modif_.operation == OPER_MULTIPLY) {
-				modifiedParamList_[paramSetIndex_][modif_.parameter] = origValue * filteredModif;
-			}
+	for (;;) {
+		const std::size_t queuedSamples = audioQueue_->capacity() - audioQueue_->writeAvailable();
+		if (queuedSamples >= lookaheadSamples_) {
+			return true;
+		}
 
-			const float coef = 1.0f / controlSteps_;
-			for (unsigned int i = 0; i < numParameters_; ++i) {
-				currentParam_[i] = modifiedParamList_[paramSetIndex_ - 1][i];
-				delta_[i] = (modifiedParamList_[paramSetIndex_][i] - modifiedParamList_[paramSetIndex_ - 1][i]) * coef;
-			}
-		} else {
-			// Do linear interpolation.
-			for (unsigned int i = 0; i < numParameters_; ++i) {
-				currentParam_[i] += delta_[i];
+		if (vtmOutputBuffer.empty()) {
+			if (!synthesisStep()) {
+				return false;
 			}
+			continue;
+		}
+
+		auto view = audioQueue_->writeView(lookaheadSamples_ - queuedSamples);
+		std::size_t n = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, view.first.data,
+							view.first.size, gain_);
+		if (n == view.first.size && view.second.size > 0) {
+			n += VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, view.second.data,
+							view.second.size, gain_);
+		}
+		audioQueue_->commitWrite(n);
+	}
+}
+
+/*******************************************************************************
+ * Executes one step of the vocal tract model.
+ *
+ * Returns false when there are no more data to process.
+ */
+bool
+ParameterModificationSynthesis::Processor::synthesisStep()
+{
+	if (paramSetIndex_ >= modifiedParamList_.size()) {
+		return false;
+	}
+
+	// Get modification data.
+	if (modificationQueue_->pop(modif_)) {
+		assert(modif_.parameter < numParameters_);
+	}
+
+	const float filteredModif = (modif_.operation != OPER_NONE) ? modifFilter_.filter(modif_.value) : 0.0;
+
+	// Calculate the parameters for the control step.
+	if (stepIndex_ == 0) {
+		// Apply the modification.
+		const float origValue = paramList_[paramSetIndex_][modif_.parameter];
+		if (modif_.operation == OPER_ADD) {
+			modifiedParamList_[paramSetIndex_][modif_.parameter] = origValue + filteredModif;
+			addModifiedParamSet(modif_.parameter, paramSetIndex_, origValue + filteredModif);
+		} else if (modif_.operation == OPER_MULTIPLY) {
+			modifiedParamList_[paramSetIndex_][modif_.parameter] = origValue * filteredModif;
+			addModifiedParamSet(modif_.parameter, paramSetIndex_, origValue * filteredModif);
 		}
 
-		if (++stepIndex_ >= controlSteps_) {
-			stepIndex_ = 0;
-			++paramSetIndex_;
+		const float coef = 1.0f / controlSteps_;
+		for (unsigned int i = 0; i < numParameters_; ++i) {
+			currentParam_[i] = modifiedParamList_[paramSetIndex_ - 1][i];
+			delta_[i] = (modifiedParamList_[paramSetIndex_][i] - modifiedParamList_[paramSetIndex_ - 1][i]) * coef;
 		}
+	} else {
+		// Do linear interpolation.
+		for (unsigned int i = 0; i < numParameters_; ++i) {
+			currentParam_[i] += delta_[i];
+		}
+	}
 
-		// Synthesize using the VTM.
-		vocalTractModel_->setAllParameters(currentParam_);
-		vocalTractModel_->execSynthesisStep();
+	if (++stepIndex_ >= controlSteps_) {
+		stepIndex_ = 0;
+		++paramSetIndex_;
 	}
 
-	const std::size_t n2 = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out + n,
-							nframes - n, gain_);
-	assert(n2 == nframes - n);
+	// Synthesize using the VTM.
+	vocalTractModel_->setAllParameters(currentParam_);
+	vocalTractModel_->execSynthesisStep();
 
-	return 0;
+	return true;
+}
+
+/*******************************************************************************
+ * Adds a parameter set to the pending modified range.
+ *
+ * The values are copied to the range, because the main thread must not
+ * read modifiedParamList_ while the render thread is running.
+ */
+void
+ParameterModificationSynthesis::Processor::addModifiedParamSet(unsigned int parameter, unsigned int paramSet, float value)
+{
+	if (pendingModifiedRangeValid_ &&
+			(pendingModifiedRange_.parameter != parameter ||
+				paramSet != pendingModifiedRange_.first + pendingModifiedRange_.size ||
+				pendingModifiedRange_.size == ModifiedRange::MAX_SIZE)) {
+		publishModifiedRange();
+		if (pendingModifiedRangeValid_) {
+			// The queue is full. Drop the oldest values.
+			pendingModifiedRangeValid_ = false;
+		}
+	}
+	if (!pendingModifiedRangeValid_) {
+		pendingModifiedRange_.parameter = parameter;
+		pendingModifiedRange_.first = paramSet;
+		pendingModifiedRange_.size = 0;
+		pendingModifiedRangeValid_ = true;
+	}
+	pendingModifiedRange_.value[pendingModifiedRange_.size++] = value;
+}
+
+/*******************************************************************************
+ * Sends the pending modified range to the main thread.
+ *
+ * If the queue is full, the range is kept and will be extended with
+ * the next modifications, while possible.
+ */
+void
+ParameterModificationSynthesis::Processor::publishModifiedRange()
+{
+	if (!pendingModifiedRangeValid_) return;
+
+	if (modifiedRangeQueue_->push(pendingModifiedRange_)) {
+		pendingModifiedRangeValid_ = false;
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+ParameterModificationSynthesis::Processor::nextModifiedRange(ModifiedRange& range)
+{
+	return modifiedRangeQueue_->pop(range);
 }
 
 /*******************************************************************************
@@ -217,10 +348,25 @@ ParameterModificationSynthesis::Processor::validData() const
  *
  */
 void
-ParameterModificationSynthesis::Processor::prepareSynthesis(jack_port_t* jackOutputPort, float gain) {
+ParameterModificationSynthesis::Processor::prepareSynthesis(jack_port_t* jackOutputPort, float gain, std::size_t lookaheadSamples) {
 	if (!jackOutputPort) {
 		THROW_EXCEPTION(MissingValueException, "Missing JACK output port.");
 	}
+	if (lookaheadSamples == 0) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid render lookahead: " << lookaheadSamples << '.');
+	}
+
+	stopRendering();
+
+	audioQueue_ = std::make_unique<SPSCQueue<jack_default_audio_sample_t>>(lookaheadSamples);
+	lookaheadSamples_ = lookaheadSamples;
+	renderFinished_ = false;
+	underflowCount_ = 0;
+	modifiedRangeQueue_->reset();
+	pendingModifiedRangeValid_ = false;
+
+	vocalTractModel_->reset();
+	vocalTractModel_->outputBuffer().clear();
 
 	outputPort_ = jackOutputPort;
 	vtmBufferPos_ = 0;
@@ -231,6 +377,36 @@ ParameterModificationSynthesis::Processor::prepareSynthesis(jack_port_t* jackOut
 	modifFilter_.reset();
 }
 
+/*******************************************************************************
+ * Fills the audio queue and starts the render thread.
+ */
+void
+ParameterModificationSynthesis::Processor::startRendering()
+{
+	if (renderThreadRunning_) return;
+
+	const bool dataAvailable = fillAudioQueue();
+	publishModifiedRange();
+	if (!dataAvailable) {
+		renderFinished_ = true;
+	}
+
+	renderThreadRunning_ = true;
+	renderThread_ = std::thread(&Processor::render, this);
+}
+
+/*******************************************************************************
+ *
+ */
+void
+ParameterModificationSynthesis::Processor::stopRendering()
+{
+	renderThreadRunning_ = false;
+	if (renderThread_.joinable()) {
+		renderThread_.join();
+	}
+}
+
 /*******************************************************************************
  *
  */
@@ -271,10 +447,10 @@ ParameterModificationSynthesis::ParameterModificationSynthesis(
 			unsigned int numberOfParameters,
 			double controlRate,
 			const ConfigurationData& vtmConfigData)
-		: parameterRingbuffer_{std::make_unique<JackRingbuffer>(PARAMETER_RINGBUFFER_SIZE * sizeof(Modification))}
+		: modificationQueue_{std::make_unique<ModificationQueue>(MODIFICATION_QUEUE_SIZE)}
 		, processor_{std::make_unique<Processor>(
 					numberOfParameters,
-					parameterRingbuffer_.get(),
+					modificationQueue_.get(),
 					vtmConfigData,
 					controlRate)}
 		, jackClient_{}
@@ -292,44 +468,56 @@ ParameterModificationSynthesis::~ParameterModificationSynthesis()
  * Starts the synthesis and the connection to the JACK server.
  */
 void
-ParameterModificationSynthesis::startSynthesis(float gain)
+ParameterModificationSynthesis::startSynthesis(float gain, unsigned int lookaheadTime)
 {
 	if (Log::debugEnabled) std::cout << "ParameterModificationSynthesis::startSynthesis" << std::endl;
 
 	if (jackClient_) return;
 
+	if (lookaheadTime == 0 || lookaheadTime > MAX_RENDER_LOOKAHEAD_MS) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid render lookahead: " << lookaheadTime << " ms.");
+	}
+
 	auto newJackClient = std::make_unique<JackClient>(CLIENT_NAME);
 
 	jack_port_t* outputPort = newJackClient->registerPort("output", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
 
-	if (Log::debugEnabled) {
-		jack_nframes_t jackSampleRate = newJackClient->getSampleRate();
-		std::cout << "Output sample rate: " << jackSampleRate << std::endl;
-	}
+	jack_nframes_t jackSampleRate = newJackClient->getSampleRate();
+	if (Log::debugEnabled) std::cout << "Output sample rate: " << jackSampleRate << std::endl;
 
 	// Prepare the audio processor.
 	if (!processor_->validData()) {
 		THROW_EXCEPTION(InvalidValueException, "Not enough data in the parameter modification synthesis processor.");
 	}
-	processor_->prepareSynthesis(outputPort, gain);
-
-	newJackClient->setProcessCallback(param_modif_jack_process_callback, processor_.get());
-	newJackClient->setShutdownCallback(param_modif_jack_shutdown_callback, processor_.get());
-
-	newJackClient->activate();
-
-	// Connect the ports. You can't do this before the client is
-	// activated, because we can't make connections to clients
-	// that aren't running. Note the confusing (but necessary)
-	// orientation of the driver backend ports: playback ports are
-	// "input" to the backend, and capture ports are "output" from it.
-	JackPorts ports;
-	newJackClient->getPorts(NULL, NULL, JackPortIsPhysical | JackPortIsInput, ports);
-	if (ports.list == NULL) {
-		THROW_EXCEPTION(AudioException, "No physical playback ports.");
-	}
-	for (size_t i = 0; i < 2 && ports.list[i]; ++i) {
-		newJackClient->connect(JackClient::portName(outputPort), ports.list[i]);
+	const std::size_t lookaheadSamples = static_cast<std::size_t>(jackSampleRate) * lookaheadTime / 1000U;
+	processor_->prepareSynthesis(outputPort, gain, lookaheadSamples);
+
+	// The audio queue is filled before the activation of the client.
+	processor_->startRendering();
+	try {
+		newJackClient->setProcessCallback(param_modif_jack_process_callback, processor_.get());
+		newJackClient->setShutdownCallback(param_modif_jack_shutdown_callback, processor_.get());
+
+		newJackClient->activate();
+
+		// Connect the ports. You can't do this before the client is
+		// activated, because we can't make connections to clients
+		// that aren't running. Note the confusing (but necessary)
+		// orientation of the driver backend ports: playback ports are
+		// "input" to the backend, and capture ports are "output" from it.
+		JackPorts ports;
+		newJackClient->getPorts(NULL, NULL, JackPortIsPhysical | JackPortIsInput, ports);
+		if (ports.list == NULL) {
+			THROW_EXCEPTION(AudioException, "No physical playback ports.");
+		}
+		for (size_t i = 0; i < 2 && ports.list[i]; ++i) {
+			newJackClient->connect(JackClient::portName(outputPort), ports.list[i]);
+		}
+	} catch (...) {
+		// The client is closed before the render thread is stopped.
+		newJackClient.reset();
+		processor_->stopRendering();
+		throw;
 	}
 
 	jackClient_ = std::move(newJackClient);
@@ -344,9 +532,12 @@ void
 ParameterModificationSynthesis::stop()
 {
 	jackClient_.reset();
-	parameterRingbuffer_->reset();
+	processor_->stopRendering();
+	modificationQueue_->reset();
 
-	if (Log::debugEnabled) std::cout << "Audio stopped." << std::endl;
+	if (Log::debugEnabled) {
+		std::cout << "Audio stopped. Render underflows: " << processor_->underflowCount() << std::endl;
+	}
 	return;
 }
 
@@ -364,13 +555,11 @@ ParameterModificationSynthesis::modifyParameter(
 		return false;
 	}
 
-	if (parameterRingbuffer_->writeSpace() >= sizeof(Modification)) {
-		Modification modif;
-		modif.parameter = parameter;
-		modif.operation = operation;
-		modif.value = value;
-		parameterRingbuffer_->write(reinterpret_cast<const char*>(&modif), sizeof(Modification));
-	}
+	Modification modif;
+	modif.parameter = parameter;
+	modif.operation = operation;
+	modif.value = value;
+	modificationQueue_->push(modif); // the modification is discarded if the queue is full
 
 	return true;
 }
@@ -20,11 +20,12 @@
 
 #include <atomic>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "JackClient.h"
-#include "JackRingbuffer.h"
 #include "MovingAverageFilter.h"
+#include "SPSCQueue.h"
 
 
 
@@ -58,11 +59,24 @@ public:
 		}
 	};
 
+	// Consecutive parameter sets modified by the processor, with the new values.
+	struct ModifiedRange {
+		enum {
+			MAX_SIZE = 32
+		};
+		unsigned int parameter;
+		unsigned int first;
+		unsigned int size;
+		float value[MAX_SIZE]; // value[i]: parameter set first + i
+	};
+
+	typedef SPSCQueue<Modification> ModificationQueue;
+
 	class Processor {
 	public:
 		Processor(
 			unsigned int numberOfParameters,
-			JackRingbuffer* parameterRingbuffer,
+			ModificationQueue* modificationQueue,
 			const ConfigurationData& vtmConfigData,
 			double controlRate);
 		~Processor();
@@ -74,19 +88,49 @@ public:
 		// These functions can be called by the main thread only when the JACK thread is not running.
 		void resetData(const std::vector<std::vector<float>>& paramList);
 		bool validData() const;
-		void prepareSynthesis(jack_port_t* jackOutputPort, float gain);
+		void prepareSynthesis(jack_port_t* jackOutputPort, float gain, std::size_t lookaheadSamples);
+		void startRendering();
+		void stopRendering();
 		template<typename T> void getModifiedParameter(unsigned int parameter, T& paramList) const;
 		template<typename T> void getParameter(unsigned int parameter, T& paramList) const;
 		void getModifiedParameterList(std::vector<std::vector<float>>& paramList) const;
 		void resetParameter(unsigned int parameter);
 
+		// These functions can be called by the main thread while the render thread is running.
+		// Returns false if there are no more modified ranges.
+		// If the main thread is late, some ranges may be lost. The complete
+		// data can be read after the synthesis.
+		bool nextModifiedRange(ModifiedRange& range);
+
 		// Can be called by any thread.
 		bool running() const;
+		unsigned int underflowCount() const { return underflowCount_; }
 	private:
+		enum {
+			RENDER_THREAD_SLEEP_US = 500,
+			MODIFIED_RANGE_QUEUE_SIZE = 64
+		};
+
+		// Called only by the render thread (or by the main thread before the render thread starts).
+		void render();
+		bool fillAudioQueue();
+		bool synthesisStep();
+		void addModifiedParamSet(unsigned int parameter, unsigned int paramSet, float value);
+		void publishModifiedRange();
+
 		unsigned int numParameters_;
 		std::atomic<jack_port_t*> outputPort_;
 		std::size_t vtmBufferPos_;
-		JackRingbuffer* parameterRingbuffer_;
+		ModificationQueue* modificationQueue_;
+		std::unique_ptr<SPSCQueue<jack_default_audio_sample_t>> audioQueue_;
+		std::size_t lookaheadSamples_;
+		std::thread renderThread_;
+		std::atomic<bool> renderThreadRunning_;
+		std::atomic<bool> renderFinished_;
+		std::atomic<unsigned int> underflowCount_;
+		std::unique_ptr<SPSCQueue<ModifiedRange>> modifiedRangeQueue_;
+		ModifiedRange pendingModifiedRange_;
+		bool pendingModifiedRangeValid_;
 		std::vector<std::vector<float>> paramList_;
 		std::vector<std::vector<float>> modifiedParamList_;
 		std::unique_ptr<VTM::VocalTractModel> vocalTractModel_;
@@ -106,7 +150,9 @@ public:
 		const ConfigurationData& vtmConfigData);
 	~ParameterModificationSynthesis();
 
-	void startSynthesis(float gain);
+	// lookaheadTime: time in milliseconds that the vocal tract model renders
+	//                ahead of the playback.
+	void startSynthesis(float gain, unsigned int lookaheadTime);
 
 	// Returns false when there are no more data to process.
 	bool modifyParameter(
@@ -120,12 +166,13 @@ public:
 	Processor& processor() { return *processor_; }
 private:
 	enum {
-		PARAMETER_RINGBUFFER_SIZE = 8
+		MODIFICATION_QUEUE_SIZE = 8,
+		MAX_RENDER_LOOKAHEAD_MS = 1000
 	};
 
 	void stop();
 
-	std::unique_ptr<JackRingbuffer> parameterRingbuffer_;
+	std::unique_ptr<ModificationQueue> modificationQueue_;
 	std::unique_ptr<Processor> processor_; // used by the JACK thread
 	std::unique_ptr<JackClient> jackClient_;
 };
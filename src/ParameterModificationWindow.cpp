@@ -17,6 +17,7 @@
 
 #include "ParameterModificationWindow.h"
 
+#include <algorithm> /* min */
 #include <cmath> /* pow */
 #include <exception>
 
@@ -35,6 +36,7 @@
 #define MAX_AMPLITUDE_SPINBOX_VALUE (60.0)
 #define DEFAULT_OUTPUT_GAIN (0.5)
 #define GAIN_INCREMENT (0.01)
+#define DEFAULT_RENDER_LOOKAHEAD_MS (20U)
 #define VTM_PARAM_FILE_NAME "generated__modif_vtm_param.txt"
 
 
@@ -62,6 +64,11 @@ ParameterModificationWindow::ParameterModificationWindow(QWidget* parent)
 		ui_->outputGainComboBox->addItem(QString::number(i), static_cast<double>(i));
 	}
 
+	for (unsigned int t : {5U, 10U, 20U, 50U, 100U, 200U}) {
+		ui_->lookaheadComboBox->addItem(QString::number(t), t);
+	}
+	ui_->lookaheadComboBox->setCurrentIndex(ui_->lookaheadComboBox->findData(DEFAULT_RENDER_LOOKAHEAD_MS));
+
 	ui_->parameterCurveWidget->addGraph(); // original parameters
 	ui_->parameterCurveWidget->graph(0)->setPen(QPen(QBrush(Qt::black), 2.0));
 	ui_->parameterCurveWidget->graph(0)->setAntialiased(true);
@@ -80,6 +87,8 @@ ParameterModificationWindow::ParameterModificationWindow(QWidget* parent)
 			this, &ParameterModificationWindow::sendModificationValue);
 	connect(&synthesisTimer_   , &QTimer::timeout,
 			this, &ParameterModificationWindow::checkSynthesis);
+	connect(&displayTimer_     , &QTimer::timeout,
+			this, &ParameterModificationWindow::updateModifiedParameterCurve);
 
 	disableWindow();
 }
@@ -192,7 +201,8 @@ ParameterModificationWindow::on_synthesizeButton_clicked()
 
 	try {
 		synthesis_->paramModifSynth->startSynthesis(
-			synthesis_->vtmController->outputScale() * outputGain());
+			synthesis_->vtmController->outputScale() * outputGain(),
+			renderLookahead());
 	} catch (const std::exception& exc) {
 		QMessageBox::critical(this, tr("Error"), exc.what());
 		enableWindow();
@@ -270,7 +280,8 @@ ParameterModificationWindow::handleModificationStarted()
 		disableInput();
 		try {
 			synthesis_->paramModifSynth->startSynthesis(
-				synthesis_->vtmController->outputScale() * outputGain());
+				synthesis_->vtmController->outputScale() * outputGain(),
+				renderLookahead());
 		} catch (const std::exception& exc) {
 			QMessageBox::critical(this, tr("Error"), exc.what());
 			enableInput();
@@ -278,6 +289,7 @@ ParameterModificationWindow::handleModificationStarted()
 			return;
 		}
 		modificationTimer_.start(MODIF_TIMER_INTERVAL_MS);
+		displayTimer_.start(DISPLAY_TIMER_INTERVAL_MS);
 		state_ = State::running;
 	}
 }
@@ -318,7 +330,9 @@ ParameterModificationWindow::sendModificationValue()
 		ui_->parameterModificationWidget->stop();
 		state_ = State::stopped;
 		modificationTimer_.stop();
-		qDebug("Modification STOP");
+		displayTimer_.stop();
+		qDebug("Modification STOP (render underflows: %u)",
+			synthesis_->paramModifSynth->processor().underflowCount());
 
 		showModifiedParameterData();
 
@@ -333,12 +347,44 @@ ParameterModificationWindow::checkSynthesis()
 {
 	if (!synthesis_->paramModifSynth->checkSynthesis()) {
 		synthesisTimer_.stop();
-		qDebug("Synthesis STOP");
+		qDebug("Synthesis STOP (render underflows: %u)",
+			synthesis_->paramModifSynth->processor().underflowCount());
 		enableWindow();
 		emit synthesisFinished();
 	}
 }
 
+// Slot.
+void
+ParameterModificationWindow::updateModifiedParameterCurve()
+{
+	if (!model_ || modifParamY_.isEmpty()) return;
+
+	const unsigned int parameter = ui_->parameterComboBox->currentIndex();
+	ParameterModificationSynthesis::Processor& processor = synthesis_->paramModifSynth->processor();
+	QVector<QCPData>* data = ui_->parameterCurveWidget->graph(1)->sortedData();
+
+	bool changed = false;
+	ParameterModificationSynthesis::ModifiedRange range;
+	while (processor.nextModifiedRange(range)) {
+		if (range.parameter != parameter) continue;
+		const unsigned int end = std::min<unsigned int>(range.first + range.size,
+						std::min<unsigned int>(modifParamY_.size(), data->size()));
+		if (range.first >= end) continue;
+
+		// Update only the modified points.
+		for (unsigned int i = range.first; i < end; ++i) {
+			modifParamY_[i] = range.value[i - range.first];
+			(*data)[i].value = modifParamY_[i];
+		}
+		changed = true;
+	}
+
+	if (changed) {
+		ui_->parameterCurveWidget->replot();
+	}
+}
+
 void
 ParameterModificationWindow::showModifiedParameterData()
 {
@@ -358,13 +404,13 @@ ParameterModificationWindow::showModifiedParameterData()
 		return;
 	}
 
-	ui_->parameterCurveWidget->graph(0)->setData(modifParamX_, paramY_);
+	ui_->parameterCurveWidget->graph(0)->setSortedData(modifParamX_, paramY_);
 	ui_->parameterCurveWidget->graph(0)->keyAxis()->setRange(modifParamX_.first(), modifParamX_.last());
 	ui_->parameterCurveWidget->graph(0)->valueAxis()->setRange(
 				model_->parameterList()[parameter].minimum(),
 				model_->parameterList()[parameter].maximum());
 	ui_->parameterCurveWidget->graph(0)->rescaleAxes(true);
-	ui_->parameterCurveWidget->graph(1)->setData(modifParamX_, modifParamY_);
+	ui_->parameterCurveWidget->graph(1)->setSortedData(modifParamX_, modifParamY_);
 	ui_->parameterCurveWidget->graph(1)->rescaleAxes(true);
 	ui_->parameterCurveWidget->replot();
 }
@@ -376,6 +422,7 @@ ParameterModificationWindow::setInputEnabled(bool enabled)
 	ui_->addRadioButton->setEnabled(enabled);
 	ui_->multiplyRadioButton->setEnabled(enabled);
 	ui_->amplitudeSpinBox->setEnabled(enabled);
+	ui_->lookaheadComboBox->setEnabled(enabled);
 	ui_->outputGainComboBox->setEnabled(enabled);
 	//ui_->parameterModificationWidget->setEnabled(enabled);
 	ui_->resetParameterButton->setEnabled(enabled);
@@ -390,4 +437,10 @@ ParameterModificationWindow::outputGain()
 	return std::pow(10.0, ui_->outputGainComboBox->currentData().toDouble() * 0.05);
 }
 
+unsigned int
+ParameterModificationWindow::renderLookahead()
+{
+	return ui_->lookaheadComboBox->currentData().toUInt();
+}
+
 } // namespace GS
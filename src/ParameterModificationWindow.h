@@ -62,10 +62,12 @@ private slots:
 	void handleOffsetChanged(double offset);
 	void sendModificationValue();
 	void checkSynthesis();
+	void updateModifiedParameterCurve();
 private:
 	enum {
 		MODIF_TIMER_INTERVAL_MS = 2,
-		SYNTH_TIMER_INTERVAL_MS = 30
+		SYNTH_TIMER_INTERVAL_MS = 30,
+		DISPLAY_TIMER_INTERVAL_MS = 40
 	};
 	enum class State {
 		stopped,
@@ -75,6 +77,7 @@ private:
 	void showModifiedParameterData();
 	void setInputEnabled(bool enabled);
 	double outputGain();
+	unsigned int renderLookahead();
 
 	std::unique_ptr<Ui::ParameterModificationWindow> ui_;
 	VTMControlModel::Model* model_;
@@ -84,6 +87,7 @@ private:
 	double modificationValue_;
 	QTimer modificationTimer_;
 	QTimer synthesisTimer_;
+	QTimer displayTimer_;
 	QVector<double> paramY_;
 	QVector<double> modifParamX_;
 	QVector<double> modifParamY_;
@@ -22,12 +22,14 @@
 
 #include "ParameterWidget.h"
 
+#include <algorithm> /* max, min */
 #include <cmath>
 #include <cstring> /* strlen */
 
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPointF>
+#include <QPolygonF>
 #include <QRectF>
 #include <QSizePolicy>
 
@@ -36,6 +38,8 @@
 
 #define MARGIN (10.0)
 #define SPEECH_SIGNAL_HEIGHT (100.0)
+#define SPECTROGRAM_HEIGHT (120.0)
+#define SIGNAL_AREA_HEIGHT (SPEECH_SIGNAL_HEIGHT + MARGIN + SPECTROGRAM_HEIGHT)
 #define DEFAULT_GRAPH_HEIGHT (120.0)
 #define MININUM_WIDTH (1024)
 #define MININUM_HEIGHT (768)
@@ -43,9 +47,16 @@
 #define DEFAULT_TIME_SCALE (0.7)
 #define POINT_RADIUS (2.0)
 #define GRAPH_HIDE_TOLERANCE (0.5)
+#define FORMANT_POINT_SIZE (2)
 
 
 
+namespace {
+
+const Qt::GlobalColor formantColorList[] = {Qt::red, Qt::darkGreen, Qt::blue, Qt::magenta}; // F1, F2, ...
+
+} /* namespace */
+
 namespace GS {
 
 ParameterWidget::ParameterWidget(QWidget* parent)
@@ -69,11 +80,14 @@ ParameterWidget::ParameterWidget(QWidget* parent)
 	setMinimumHeight(totalHeight_);
 
 	setMouseTracking(true);
+
+	connect(&spectrogram_, &SpeechSpectrogram::finished, this, [this]() { update(); });
+	connect(&formantTracker_, &FormantTracker::finished, this, [this]() { update(); });
 }
 
 // Note: with no antialiasing, the coordinates in QPointF are rounded to the nearest integer.
 void
-ParameterWidget::paintEvent(QPaintEvent* /*event*/)
+ParameterWidget::paintEvent(QPaintEvent* event)
 {
 	if (eventList_ == nullptr || eventList_->list().empty()) {
 		return;
@@ -125,7 +139,7 @@ ParameterWidget::paintEvent(QPaintEvent* /*event*/)
 	setMinimumWidth(totalWidth_);
 	setMinimumHeight(totalHeight_);
 
-	const double headerBottomY = MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + 2.0 * textTotalHeight_;
+	const double headerBottomY = MARGIN * 2.0 + SIGNAL_AREA_HEIGHT + 2.0 * textTotalHeight_;
 	const QPalette pal;
 
 	if (!selectedParamList_.empty()) {
@@ -142,9 +156,55 @@ ParameterWidget::paintEvent(QPaintEvent* /*event*/)
 			}
 		}
 
+		// Spectrogram.
+		if (spectrogram_.ready()) {
+			const double yTop = MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + verticalScrollbarValue_;
+			const double frameWidth = spectrogram_.frameDuration() * timeScale_;
+			// Use the level with approximately one column per pixel.
+			unsigned int level = 0;
+			while (level + 1U < spectrogram_.numLevels() && frameWidth * (1U << (level + 1U)) <= 1.0) {
+				++level;
+			}
+			const double columnWidth = frameWidth * (1U << level);
+			const double tileWidth = columnWidth * SpeechSpectrogram::TILE_WIDTH;
+			const unsigned int numColumns = (spectrogram_.numFrames() + (1U << level) - 1U) >> level;
+			const int numTiles = (numColumns + SpeechSpectrogram::TILE_WIDTH - 1U) / SpeechSpectrogram::TILE_WIDTH;
+
+			// Draw only the visible tiles.
+			const int firstTile = std::max(static_cast<int>(std::floor((event->rect().left()  - xBase) / tileWidth)), 0);
+			const int lastTile  = std::min(static_cast<int>(std::floor((event->rect().right() - xBase) / tileWidth)), numTiles - 1);
+			for (int i = firstTile; i <= lastTile; ++i) {
+				const QImage& image = spectrogram_.tile(level, i);
+				painter.drawImage(QRectF(xBase + i * tileWidth, yTop, image.width() * columnWidth, SPECTROGRAM_HEIGHT), image);
+			}
+
+			// Formant tracks (only the visible frames, at most one per pixel).
+			if (formantTracker_.ready()) {
+				const double formantFrameWidth = formantTracker_.frameDuration() * timeScale_;
+				const unsigned int frameStep = std::max(static_cast<unsigned int>(1.0 / formantFrameWidth), 1U);
+				const unsigned int numFrames = formantTracker_.numFrames();
+				const unsigned int firstFrame = std::min(static_cast<unsigned int>(std::max((event->rect().left() - xBase) / formantFrameWidth, 0.0)), numFrames);
+				const unsigned int endFrame   = std::min(static_cast<unsigned int>(std::max((event->rect().right() - xBase) / formantFrameWidth + 1.0, 0.0)), numFrames);
+				const double yCoef = SPECTROGRAM_HEIGHT / spectrogram_.maxFreq();
+				QPolygonF points;
+				painter.save();
+				for (unsigned int i = 0; i < FormantTracker::NUM_FORMANTS; ++i) {
+					points.clear();
+					for (unsigned int f = firstFrame - firstFrame % frameStep; f < endFrame; f += frameStep) {
+						const double freq = formantTracker_.formant(f, i);
+						if (freq <= 0.0 || freq > spectrogram_.maxFreq()) continue;
+						points.append(QPointF(xBase + (f + 0.5) * formantFrameWidth, yTop + SPECTROGRAM_HEIGHT - freq * yCoef));
+					}
+					painter.setPen(QPen(formantColorList[i], FORMANT_POINT_SIZE));
+					painter.drawPoints(points);
+				}
+				painter.restore();
+			}
+		}
+
 		postureTimeList_.clear();
 
-		const double yPosture = MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + textTotalHeight_ + textYOffset + verticalScrollbarValue_;
+		const double yPosture = MARGIN * 2.0 + SIGNAL_AREA_HEIGHT + textTotalHeight_ + textYOffset + verticalScrollbarValue_;
 		unsigned int postureIndex = 0;
 		for (const VTMControlModel::Event_ptr& ev : eventList_->list()) {
 			const double x = xBase + ev->time * timeScale_;
@@ -171,7 +231,7 @@ ParameterWidget::paintEvent(QPaintEvent* /*event*/)
 			}
 		}
 
-		const double yRuleText = MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + textYOffset + verticalScrollbarValue_;
+		const double yRuleText = MARGIN * 2.0 + SIGNAL_AREA_HEIGHT + textYOffset + verticalScrollbarValue_;
 
 		for (int i = 0; i < eventList_->numberOfRules(); ++i) {
 			const auto* ruleData = eventList_->getRuleDataAtIndex(i);
@@ -195,8 +255,8 @@ ParameterWidget::paintEvent(QPaintEvent* /*event*/)
 				const double xPost2 = xBase + postureTime2 * timeScale_;
 				// Rule frame.
 				painter.drawRect(QRectF(
-						QPointF(xPost1, MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + verticalScrollbarValue_),
-						QPointF(xPost2, MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + textTotalHeight_ + verticalScrollbarValue_)));
+						QPointF(xPost1, MARGIN * 2.0 + SIGNAL_AREA_HEIGHT + verticalScrollbarValue_),
+						QPointF(xPost2, MARGIN * 2.0 + SIGNAL_AREA_HEIGHT + textTotalHeight_ + verticalScrollbarValue_)));
 				// Rule number.
 				painter.drawText(QPointF(xPost1 + TEXT_MARGIN, yRuleText), QString::number(ruleData->number));
 			}
@@ -210,6 +270,25 @@ ParameterWidget::paintEvent(QPaintEvent* /*event*/)
 
 		QString ruleLabel = tr("Rule");
 		painter.drawText(QPointF(MARGIN + (labelWidth_ - fm.width(ruleLabel)) + horizontalScrollbarValue_, yRuleText), ruleLabel);
+
+		if (spectrogram_.ready()) {
+			// Frequency limits.
+			const double yTop = MARGIN * 2.0 + SPEECH_SIGNAL_HEIGHT + verticalScrollbarValue_;
+			const double xFreqText = MARGIN + horizontalScrollbarValue_;
+			painter.drawText(QPointF(xFreqText, yTop + fontAscent)        , QString("%1 Hz").arg(spectrogram_.maxFreq(), 0, 'f', 0));
+			painter.drawText(QPointF(xFreqText, yTop + SPECTROGRAM_HEIGHT), QString("0 Hz"));
+
+			if (formantTracker_.ready()) {
+				// Legend.
+				painter.save();
+				const double yLegend = yTop + 0.5 * (SPECTROGRAM_HEIGHT - FormantTracker::NUM_FORMANTS * textTotalHeight_) + fontAscent;
+				for (unsigned int i = 0; i < FormantTracker::NUM_FORMANTS; ++i) {
+					painter.setPen(formantColorList[i]);
+					painter.drawText(QPointF(xFreqText, yLegend + i * textTotalHeight_), QString("F%1").arg(i + 1U));
+				}
+				painter.restore();
+			}
+		}
 	}
 
 	const QPen pen;
@@ -360,7 +439,7 @@ ParameterWidget::mouseDoubleClickEvent(QMouseEvent* /*event*/)
 double
 ParameterWidget::getGraphBaseY(unsigned int index)
 {
-	return MARGIN + SPEECH_SIGNAL_HEIGHT + 2.0 * textTotalHeight_ + (MARGIN + graphHeight_) * (index + 1U);
+	return MARGIN + SIGNAL_AREA_HEIGHT + 2.0 * textTotalHeight_ + (MARGIN + graphHeight_) * (index + 1U);
 }
 
 QSize
@@ -385,6 +464,20 @@ ParameterWidget::updateData(
 
 	selectedParamList_.clear();
 
+	updateSpeechSignal();
+}
+
+void
+ParameterWidget::updateSpeechSignal()
+{
+	if (speechSignal_ && !speechSignal_->empty() && speechSamplerate_) {
+		spectrogram_.compute(*speechSignal_, *speechSamplerate_);
+		formantTracker_.compute(*speechSignal_, *speechSamplerate_);
+	} else {
+		spectrogram_.clear();
+		formantTracker_.clear();
+	}
+
 	update();
 }
 
@@ -22,6 +22,9 @@
 
 #include <QWidget>
 
+#include "FormantTracker.h"
+#include "SpeechSpectrogram.h"
+
 
 
 namespace GS {
@@ -42,6 +45,8 @@ public:
 		const VTMControlModel::Model* model,
 		const std::vector<float>* speechSignal,
 		const double* speechSamplerate);
+	// Must be called after the speech signal has been modified.
+	void updateSpeechSignal();
 	void changeParameterSelection(unsigned int paramIndex, bool selected);
 	double xZoomMin() const { return 0.1; }
 	double xZoomMax() const { return 10.0; }
@@ -79,6 +84,8 @@ private:
 	int textTotalHeight_;
 	std::vector<unsigned int> selectedParamList_;
 	std::vector<int> postureTimeList_;
+	SpeechSpectrogram spectrogram_;
+	FormantTracker formantTracker_;
 };
 
 } // namespace GS
@@ -0,0 +1,284 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "PitchTracker.h"
+
+#include <algorithm> /* max */
+#include <cmath> /* ceil, floor, pow, rint, sqrt */
+#include <memory>
+#include <utility> /* move */
+
+#include "FFTW.h"
+#include "SpectrumKernels.h"
+
+#define MIN_F0 (50.0) // Hz
+#define MAX_F0 (500.0) // Hz
+#define HOP_DURATION_MS (5.0)
+#define YIN_THRESHOLD (0.15)
+#define SILENCE_DB (-40.0) // relative to the peak of the signal
+
+
+
+namespace GS {
+
+struct PitchTracker::Analysis {
+	std::vector<float> signal;
+	double sampleRate;
+	unsigned int minLag;
+	unsigned int maxLag;
+	unsigned int integrationSize; // samples in the sum of the difference function
+	unsigned int frameSize; // integrationSize + maxLag
+	unsigned int dftSize;
+	unsigned int hopSize;
+	unsigned int numFrames;
+	double frameDuration;
+	double silenceLevel; // RMS
+	std::vector<float> f0List; // Hz
+};
+
+class PitchTracker::FrameAnalyzer {
+public:
+	explicit FrameAnalyzer(const Analysis& analysis)
+			: analysis_{analysis}
+			, in_{}
+			, out1_{}
+			, out2_{}
+			, corr_{} {}
+	~FrameAnalyzer();
+
+	void prepare();
+	// Returns the F0, or 0.0 if the frame is unvoiced.
+	double analyzeFrame(const float* frame);
+private:
+	FrameAnalyzer(const FrameAnalyzer&) = delete;
+	FrameAnalyzer& operator=(const FrameAnalyzer&) = delete;
+
+	const Analysis& analysis_;
+	float* in_;
+	fftwf_complex* out1_;
+	fftwf_complex* out2_;
+	float* corr_;
+	FFTWPlan forwardPlan_;
+	FFTWPlan forwardPlan2_;
+	FFTWPlan inversePlan_;
+	std::vector<double> diff_;
+};
+
+PitchTracker::FrameAnalyzer::~FrameAnalyzer()
+{
+	{
+		FFTW fftw;
+		fftw.destroy_plan(inversePlan_);
+		fftw.destroy_plan(forwardPlan2_);
+		fftw.destroy_plan(forwardPlan_);
+	}
+	if (corr_) FFTW::free(corr_);
+	if (out2_) FFTW::free(out2_);
+	if (out1_) FFTW::free(out1_);
+	if (in_) FFTW::free(in_);
+}
+
+void
+PitchTracker::FrameAnalyzer::prepare()
+{
+	const unsigned int n = analysis_.dftSize;
+	in_   = FFTW::alloc_real<float>(n);
+	out1_ = FFTW::alloc_complex<float>(n / 2U + 1U);
+	out2_ = FFTW::alloc_complex<float>(n / 2U + 1U);
+	corr_ = FFTW::alloc_real<float>(n);
+	{
+		FFTW fftw;
+		forwardPlan_  = fftw.plan_dft_r2c_1d(n, in_, out1_, FFTW_ESTIMATE);
+		forwardPlan2_ = fftw.plan_dft_r2c_1d(n, in_, out2_, FFTW_ESTIMATE);
+		inversePlan_  = fftw.plan_idft_c2r_1d(n, out1_, corr_, FFTW_ESTIMATE);
+	}
+	diff_.resize(analysis_.maxLag + 2U);
+}
+
+double
+PitchTracker::FrameAnalyzer::analyzeFrame(const float* frame)
+{
+	const unsigned int n = analysis_.dftSize;
+	const unsigned int w = analysis_.integrationSize;
+
+	double energy = 0.0;
+	for (unsigned int i = 0; i < analysis_.frameSize; ++i) {
+		energy += static_cast<double>(frame[i]) * frame[i];
+	}
+	if (std::sqrt(energy / analysis_.frameSize) < analysis_.silenceLevel) {
+		return 0.0;
+	}
+
+	// Cross-correlation between the first w samples and the whole frame:
+	// r(lag) = sum(x[j] * x[j + lag]), j = 0..w-1.
+	// dftSize >= frameSize, so the lags 0..maxLag are not aliased.
+	for (unsigned int i = 0; i < w; ++i) in_[i] = frame[i];
+	for (unsigned int i = w; i < n; ++i) in_[i] = 0.0f;
+	FFTW::execute(forwardPlan_);
+	for (unsigned int i = 0; i < analysis_.frameSize; ++i) in_[i] = frame[i];
+	for (unsigned int i = analysis_.frameSize; i < n; ++i) in_[i] = 0.0f;
+	FFTW::execute(forwardPlan2_);
+	for (unsigned int i = 0, size = n / 2U + 1U; i < size; ++i) {
+		// conj(X1) * X2
+		const float re1 = out1_[i][FFTW::REAL], im1 = out1_[i][FFTW::IMAG];
+		const float re2 = out2_[i][FFTW::REAL], im2 = out2_[i][FFTW::IMAG];
+		out1_[i][FFTW::REAL] = re1 * re2 + im1 * im2;
+		out1_[i][FFTW::IMAG] = re1 * im2 - im1 * re2;
+	}
+	FFTW::execute(inversePlan_); // not normalized
+
+	// Difference function:
+	// d(lag) = sum(x[j]^2) + sum(x[j + lag]^2) - 2 * r(lag), j = 0..w-1.
+	double energy0 = 0.0;
+	for (unsigned int i = 0; i < w; ++i) {
+		energy0 += static_cast<double>(frame[i]) * frame[i];
+	}
+	double energyLag = energy0;
+	const double corrCoef = 1.0 / n;
+	for (unsigned int lag = 0; lag <= analysis_.maxLag + 1U; ++lag) {
+		if (lag > 0) {
+			energyLag += static_cast<double>(frame[lag + w - 1U]) * frame[lag + w - 1U] -
+					static_cast<double>(frame[lag - 1U]) * frame[lag - 1U];
+		}
+		diff_[lag] = std::max(energy0 + energyLag - 2.0 * corrCoef * corr_[lag], 0.0);
+	}
+
+	// Cumulative mean normalized difference.
+	diff_[0] = 1.0;
+	double sum = 0.0;
+	for (unsigned int lag = 1; lag <= analysis_.maxLag + 1U; ++lag) {
+		sum += diff_[lag];
+		diff_[lag] = (sum > 0.0) ? diff_[lag] * lag / sum : 1.0;
+	}
+
+	// The first minimum below the threshold.
+	unsigned int lag = analysis_.minLag;
+	while (lag <= analysis_.maxLag && diff_[lag] >= YIN_THRESHOLD) {
+		++lag;
+	}
+	if (lag > analysis_.maxLag) {
+		return 0.0; // unvoiced
+	}
+	while (lag < analysis_.maxLag && diff_[lag + 1U] < diff_[lag]) {
+		++lag;
+	}
+
+	// Parabolic interpolation.
+	double period = lag;
+	const double y0 = diff_[lag - 1U], y1 = diff_[lag], y2 = diff_[lag + 1U];
+	const double denom = y0 - 2.0 * y1 + y2;
+	if (denom > 0.0) {
+		period += 0.5 * (y0 - y2) / denom;
+	}
+	return analysis_.sampleRate / period;
+}
+
+PitchTracker::PitchTracker(QObject* parent)
+		: QObject{parent}
+{
+}
+
+PitchTracker::~PitchTracker()
+{
+}
+
+void
+PitchTracker::compute(const std::vector<float>& signal, double sampleRate)
+{
+	const Analysis* prevAnalysis = job_.data();
+	if (prevAnalysis && prevAnalysis->sampleRate == sampleRate && prevAnalysis->signal == signal) {
+		return; // already computed
+	}
+
+	clear();
+	if (signal.empty() || sampleRate <= 0.0) return;
+
+	auto analysis = std::make_unique<Analysis>();
+	analysis->signal = signal;
+	analysis->sampleRate = sampleRate;
+	analysis->minLag = std::max(static_cast<unsigned int>(std::floor(sampleRate / MAX_F0)), 2U);
+	analysis->maxLag = std::max(static_cast<unsigned int>(std::ceil(sampleRate / MIN_F0)), analysis->minLag + 1U);
+	analysis->integrationSize = analysis->maxLag;
+	analysis->frameSize = analysis->integrationSize + analysis->maxLag + 2U;
+	analysis->dftSize = 1;
+	while (analysis->dftSize < analysis->frameSize) {
+		analysis->dftSize *= 2;
+	}
+	analysis->hopSize = std::max(static_cast<unsigned int>(std::rint(HOP_DURATION_MS * 1.0e-3 * sampleRate)), 1U);
+	analysis->numFrames = (signal.size() + analysis->hopSize - 1U) / analysis->hopSize;
+	analysis->frameDuration = 1000.0 * analysis->hopSize / sampleRate;
+	analysis->silenceLevel = SpectrumKernels::maxAbs(&signal[0], signal.size()) * std::pow(10.0, SILENCE_DB / 20.0);
+	analysis->f0List.assign(analysis->numFrames, 0.0f);
+
+	const unsigned int numFrames = analysis->numFrames;
+	job_.start(std::move(analysis), numFrames, &PitchTracker::analyzeFrames, nullptr,
+			[this]() { emit finished(); });
+}
+
+void
+PitchTracker::clear()
+{
+	job_.cancel();
+}
+
+// Called by the tasks of the job.
+void
+PitchTracker::analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+				const std::atomic<bool>& canceled)
+{
+	FrameAnalyzer analyzer{analysis};
+	analyzer.prepare();
+
+	std::vector<float> frame(analysis.frameSize);
+	const long signalSize = analysis.signal.size();
+	for (unsigned int f = firstFrame; f < endFrame && !canceled; ++f) {
+		// The frame is centered in the hop interval.
+		const long start = static_cast<long>(f) * analysis.hopSize + analysis.hopSize / 2 - analysis.frameSize / 2;
+		for (unsigned int i = 0; i < analysis.frameSize; ++i) {
+			const long pos = start + i;
+			frame[i] = (pos >= 0 && pos < signalSize) ? analysis.signal[pos] : 0.0f;
+		}
+		analysis.f0List[f] = analyzer.analyzeFrame(&frame[0]);
+	}
+}
+
+bool
+PitchTracker::ready() const
+{
+	return job_.ready();
+}
+
+double
+PitchTracker::frameDuration() const
+{
+	return job_.data()->frameDuration;
+}
+
+unsigned int
+PitchTracker::numFrames() const
+{
+	return job_.data()->numFrames;
+}
+
+float
+PitchTracker::f0(unsigned int frame) const
+{
+	return job_.data()->f0List[frame];
+}
+
+} // namespace GS
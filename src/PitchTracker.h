@@ -0,0 +1,74 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef PITCH_TRACKER_H
+#define PITCH_TRACKER_H
+
+#include <atomic>
+#include <vector>
+
+#include <QObject>
+
+#include "FrameRangeJob.h"
+
+
+
+namespace GS {
+
+// Estimates the fundamental frequency of a synthesized utterance, using the
+// YIN algorithm. The difference function is obtained from the
+// cross-correlation, which is computed with FFTW.
+//
+// The results are kept until a different signal is passed to compute().
+class PitchTracker : public QObject {
+	Q_OBJECT
+public:
+	explicit PitchTracker(QObject* parent=nullptr);
+	virtual ~PitchTracker();
+
+	// Starts the computation. Cancels the previous computation.
+	// Does nothing if the signal and the sample rate have not changed.
+	void compute(const std::vector<float>& signal, double sampleRate);
+	void clear();
+
+	// The functions below must be called only if ready() returns true.
+	bool ready() const;
+	double frameDuration() const; // ms
+	unsigned int numFrames() const;
+	// Returns the fundamental frequency (Hz) in the frame,
+	// or 0.0 if the frame is unvoiced.
+	float f0(unsigned int frame) const;
+signals:
+	// Emitted from a thread of the pool.
+	void finished();
+private:
+	struct Analysis;
+	class FrameAnalyzer;
+
+	PitchTracker(const PitchTracker&) = delete;
+	PitchTracker& operator=(const PitchTracker&) = delete;
+
+	static void analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+					const std::atomic<bool>& canceled);
+
+	FrameRangeJob<Analysis> job_;
+};
+
+} // namespace GS
+
+#endif // PITCH_TRACKER_H
@@ -0,0 +1,167 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "RealtimeLog.h"
+
+#include <chrono>
+#include <cstddef> /* std::size_t */
+#include <iostream>
+
+#include "Log.h"
+
+
+
+namespace {
+
+using namespace GS;
+
+constexpr std::size_t NUM_RECORDS = 256; // must be a power of two
+constexpr std::size_t SOURCE_SIZE = 64;
+constexpr std::size_t MESSAGE_SIZE = 192;
+constexpr unsigned int MAX_POST_ATTEMPTS = 8;
+
+struct Record {
+	// Equal to the write position when the record is free,
+	// and to the write position + 1 when it contains a message.
+	std::atomic<std::size_t> sequence;
+	RealtimeLog::Level level;
+	char source[SOURCE_SIZE];
+	char message[MESSAGE_SIZE];
+};
+
+// Bounded multiple-producer single-consumer queue
+// (based on the bounded MPMC queue by Dmitry Vyukov).
+struct RecordBuffer {
+	Record record[NUM_RECORDS];
+	std::atomic<std::size_t> writePos;
+	std::atomic<unsigned int> numDiscarded;
+	std::size_t readPos; // used only by the consumer
+
+	RecordBuffer() : writePos{}, numDiscarded{}, readPos{} {
+		for (std::size_t i = 0; i < NUM_RECORDS; ++i) {
+			record[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+};
+
+RecordBuffer recordBuffer;
+
+void
+copyString(char* dest, const char* src, std::size_t destSize) noexcept
+{
+	std::size_t i = 0;
+	if (src) {
+		for ( ; i < destSize - 1 && src[i] != '\0'; ++i) {
+			dest[i] = src[i];
+		}
+	}
+	dest[i] = '\0';
+}
+
+} /* namespace */
+
+namespace GS {
+namespace RealtimeLog {
+
+void
+post(Level level, const char* source, const char* message) noexcept
+{
+	if (level == LEVEL_DEBUG && !Log::debugEnabled) return;
+
+	std::size_t pos = recordBuffer.writePos.load(std::memory_order_relaxed);
+	Record* rec = nullptr;
+	for (unsigned int i = 0; i < MAX_POST_ATTEMPTS; ++i) {
+		Record& r = recordBuffer.record[pos & (NUM_RECORDS - 1)];
+		const std::size_t seq = r.sequence.load(std::memory_order_acquire);
+		const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+		if (dif == 0) {
+			if (recordBuffer.writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				rec = &r;
+				break;
+			}
+		} else if (dif < 0) {
+			break; // full
+		} else {
+			pos = recordBuffer.writePos.load(std::memory_order_relaxed);
+		}
+	}
+	if (!rec) {
+		recordBuffer.numDiscarded.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	rec->level = level;
+	copyString(rec->source, source, SOURCE_SIZE);
+	copyString(rec->message, message, MESSAGE_SIZE);
+	rec->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void
+drain()
+{
+	for (;;) {
+		Record& r = recordBuffer.record[recordBuffer.readPos & (NUM_RECORDS - 1)];
+		if (r.sequence.load(std::memory_order_acquire) != recordBuffer.readPos + 1) {
+			break; // empty, or the record is being written
+		}
+
+		std::ostream& out = (r.level == LEVEL_ERROR) ? std::cerr : std::cout;
+		out << '[' << r.source << "] " << r.message << std::endl;
+
+		r.sequence.store(recordBuffer.readPos + NUM_RECORDS, std::memory_order_release);
+		++recordBuffer.readPos;
+	}
+
+	const unsigned int numDiscarded = recordBuffer.numDiscarded.exchange(0, std::memory_order_relaxed);
+	if (numDiscarded > 0) {
+		std::cerr << "[RealtimeLog] " << numDiscarded << " message(s) discarded." << std::endl;
+	}
+}
+
+/*******************************************************************************
+ * Constructor.
+ */
+DrainThread::DrainThread()
+		: running_{true}
+		, thread_{&DrainThread::run, this}
+{
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+DrainThread::~DrainThread()
+{
+	running_ = false;
+	thread_.join();
+	drain();
+}
+
+/*******************************************************************************
+ *
+ */
+void
+DrainThread::run()
+{
+	while (running_) {
+		drain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_INTERVAL_MS));
+	}
+}
+
+} /* namespace RealtimeLog */
+} /* namespace GS */
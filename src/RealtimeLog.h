@@ -0,0 +1,73 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef REALTIME_LOG_H
+#define REALTIME_LOG_H
+
+#include <atomic>
+#include <thread>
+
+
+
+namespace GS {
+
+// Log channel for the realtime threads.
+//
+// post() copies the message to a fixed-size record in a static ring buffer.
+// It never locks, allocates or throws, and gives up after a bounded number of
+// attempts, so it can be called from the JACK threads. If the ring buffer is
+// full, the message is discarded.
+// The records are written to std::cout/std::cerr by the thread owned by
+// RealtimeLog::DrainThread.
+namespace RealtimeLog {
+
+enum Level {
+	LEVEL_DEBUG,
+	LEVEL_ERROR
+};
+
+// Can be called by any thread.
+// The debug messages are discarded if Log::debugEnabled is false.
+void post(Level level, const char* source, const char* message) noexcept;
+
+// Writes all the pending records.
+void drain();
+
+// The thread starts in the constructor and stops in the destructor.
+// Only one instance must exist.
+class DrainThread {
+public:
+	DrainThread();
+	~DrainThread();
+private:
+	enum {
+		DRAIN_INTERVAL_MS = 50
+	};
+
+	DrainThread(const DrainThread&) = delete;
+	DrainThread& operator=(const DrainThread&) = delete;
+
+	void run();
+
+	std::atomic<bool> running_;
+	std::thread thread_;
+};
+
+} /* namespace RealtimeLog */
+} /* namespace GS */
+
+#endif // REALTIME_LOG_H
@@ -0,0 +1,335 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <algorithm> /* min */
+#include <atomic>
+#include <cstddef> /* std::size_t */
+#include <cstring> /* memcpy */
+#include <memory>
+#include <type_traits>
+
+#include "Exception.h"
+
+#define SPSC_QUEUE_CACHE_LINE_SIZE 64
+
+
+
+namespace GS {
+
+struct SPSCQueueException : public virtual Exception {};
+
+// Lock-free bounded queue, for one producer thread and one consumer thread.
+//
+// The capacity is rounded up to a power of two. All the positions can be used.
+//
+// Producer functions: writeAvailable, push, writeView, commitWrite.
+// Consumer functions: readAvailable, pop, peek, readView, commitRead, skip.
+//
+// Overwrite mode: if the producer uses pushOverwrite, the oldest elements
+// are overwritten when the queue is full, and the consumer must use only
+// readAvailable and popLatest. pushOverwrite publishes the end of the write
+// in progress before copying the elements (as in a seqlock), so popLatest
+// can detect that the elements it has read were being overwritten.
+template<typename T>
+class SPSCQueue {
+	static_assert(std::is_trivially_copyable<T>::value, "The element type must be trivially copyable.");
+public:
+	struct Span {
+		T* data;
+		std::size_t size;
+	};
+	// The elements of the queue may be split in two segments, because of the
+	// wrap around.
+	struct View {
+		Span first;
+		Span second;
+		std::size_t size() const { return first.size + second.size; }
+	};
+
+	explicit SPSCQueue(std::size_t minCapacity);
+	~SPSCQueue() = default;
+
+	std::size_t capacity() const { return capacity_; }
+
+	std::size_t readAvailable() const;
+	std::size_t writeAvailable() const;
+
+	bool push(const T& value);
+	// Returns the number of elements written.
+	std::size_t push(const T* src, std::size_t n);
+	// Returns a view of up to maxCount free positions.
+	// The elements must be written directly in the view, then published
+	// with commitWrite().
+	View writeView(std::size_t maxCount);
+	void commitWrite(std::size_t n);
+	// Overwrite mode. Always writes the elements (only the last capacity()
+	// elements if n > capacity()).
+	void pushOverwrite(const T* src, std::size_t n);
+
+	bool pop(T& value);
+	// Returns the number of elements read.
+	std::size_t pop(T* dest, std::size_t n);
+	// Returns the number of elements read. The elements are not removed.
+	std::size_t peek(T* dest, std::size_t n) const;
+	// Returns a view of up to maxCount elements, without copying them.
+	// The elements must be released with commitRead().
+	View readView(std::size_t maxCount) const;
+	void commitRead(std::size_t n);
+	// Removes up to n elements. Returns the number of elements removed.
+	std::size_t skip(std::size_t n);
+	// Overwrite mode. Reads the most recent n elements, and removes all the
+	// elements. Returns the number of elements read, that may be less than n
+	// if the queue does not have enough elements.
+	std::size_t popLatest(T* dest, std::size_t n);
+
+	void reset(); // not thread safe
+private:
+	enum {
+		PADDING_SIZE = SPSC_QUEUE_CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>),
+		MAX_POP_LATEST_ATTEMPTS = 4
+	};
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	static std::size_t roundToPowerOfTwo(std::size_t n);
+	View makeView(std::size_t index, std::size_t n) const;
+
+	const std::size_t capacity_;
+	const std::size_t mask_;
+	std::unique_ptr<T[]> buffer_;
+
+	// The indexes are not wrapped. Each one is in its own cache line.
+	char padding0_[SPSC_QUEUE_CACHE_LINE_SIZE];
+	std::atomic<std::size_t> writeIndex_;
+	char padding1_[PADDING_SIZE];
+	std::atomic<std::size_t> readIndex_;
+	char padding2_[PADDING_SIZE];
+	std::atomic<std::size_t> pendingWriteIndex_; // overwrite mode: end of the write in progress
+	char padding3_[PADDING_SIZE];
+};
+
+template<typename T>
+SPSCQueue<T>::SPSCQueue(std::size_t minCapacity)
+		: capacity_{roundToPowerOfTwo(minCapacity)}
+		, mask_{capacity_ - 1U}
+		, buffer_{std::make_unique<T[]>(capacity_)}
+		, writeIndex_{}
+		, readIndex_{}
+		, pendingWriteIndex_{}
+{
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::roundToPowerOfTwo(std::size_t n)
+{
+	if (n == 0) {
+		THROW_EXCEPTION(SPSCQueueException, "Invalid queue capacity: 0.");
+	}
+	std::size_t capacity = 1;
+	while (capacity < n) {
+		capacity <<= 1;
+		if (capacity == 0) {
+			THROW_EXCEPTION(SPSCQueueException, "Invalid queue capacity: " << n << '.');
+		}
+	}
+	return capacity;
+}
+
+template<typename T>
+typename SPSCQueue<T>::View
+SPSCQueue<T>::makeView(std::size_t index, std::size_t n) const
+{
+	const std::size_t pos = index & mask_;
+	const std::size_t firstSize = std::min(n, capacity_ - pos);
+	return View{
+		Span{buffer_.get() + pos, firstSize},
+		Span{buffer_.get(), n - firstSize}
+	};
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::readAvailable() const
+{
+	return writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::writeAvailable() const
+{
+	return capacity_ - (writeIndex_.load(std::memory_order_relaxed) - readIndex_.load(std::memory_order_acquire));
+}
+
+template<typename T>
+bool
+SPSCQueue<T>::push(const T& value)
+{
+	const std::size_t w = writeIndex_.load(std::memory_order_relaxed);
+	if (w - readIndex_.load(std::memory_order_acquire) == capacity_) {
+		return false;
+	}
+	buffer_[w & mask_] = value;
+	writeIndex_.store(w + 1U, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::push(const T* src, std::size_t n)
+{
+	View view = writeView(n);
+	std::memcpy(view.first.data, src, view.first.size * sizeof(T));
+	std::memcpy(view.second.data, src + view.first.size, view.second.size * sizeof(T));
+	commitWrite(view.size());
+	return view.size();
+}
+
+template<typename T>
+typename SPSCQueue<T>::View
+SPSCQueue<T>::writeView(std::size_t maxCount)
+{
+	const std::size_t w = writeIndex_.load(std::memory_order_relaxed);
+	const std::size_t n = std::min(maxCount, capacity_ - (w - readIndex_.load(std::memory_order_acquire)));
+	return makeView(w, n);
+}
+
+template<typename T>
+void
+SPSCQueue<T>::commitWrite(std::size_t n)
+{
+	writeIndex_.store(writeIndex_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+template<typename T>
+void
+SPSCQueue<T>::pushOverwrite(const T* src, std::size_t n)
+{
+	if (n > capacity_) {
+		src += n - capacity_;
+		n = capacity_;
+	}
+	const std::size_t w = writeIndex_.load(std::memory_order_relaxed);
+	// Announce the write before modifying the elements.
+	pendingWriteIndex_.store(w + n, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	View view = makeView(w, n);
+	std::memcpy(view.first.data, src, view.first.size * sizeof(T));
+	std::memcpy(view.second.data, src + view.first.size, view.second.size * sizeof(T));
+	writeIndex_.store(w + n, std::memory_order_release);
+}
+
+template<typename T>
+bool
+SPSCQueue<T>::pop(T& value)
+{
+	const std::size_t r = readIndex_.load(std::memory_order_relaxed);
+	if (writeIndex_.load(std::memory_order_acquire) == r) {
+		return false;
+	}
+	value = buffer_[r & mask_];
+	readIndex_.store(r + 1U, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::pop(T* dest, std::size_t n)
+{
+	const std::size_t numRead = peek(dest, n);
+	commitRead(numRead);
+	return numRead;
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::peek(T* dest, std::size_t n) const
+{
+	View view = readView(n);
+	std::memcpy(dest, view.first.data, view.first.size * sizeof(T));
+	std::memcpy(dest + view.first.size, view.second.data, view.second.size * sizeof(T));
+	return view.size();
+}
+
+template<typename T>
+typename SPSCQueue<T>::View
+SPSCQueue<T>::readView(std::size_t maxCount) const
+{
+	const std::size_t r = readIndex_.load(std::memory_order_relaxed);
+	const std::size_t n = std::min(maxCount, writeIndex_.load(std::memory_order_acquire) - r);
+	return makeView(r, n);
+}
+
+template<typename T>
+void
+SPSCQueue<T>::commitRead(std::size_t n)
+{
+	readIndex_.store(readIndex_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::skip(std::size_t n)
+{
+	const std::size_t numSkipped = std::min(n, readAvailable());
+	commitRead(numSkipped);
+	return numSkipped;
+}
+
+template<typename T>
+std::size_t
+SPSCQueue<T>::popLatest(T* dest, std::size_t n)
+{
+	const std::size_t r = readIndex_.load(std::memory_order_relaxed);
+	for (int i = 0; i < MAX_POP_LATEST_ATTEMPTS; ++i) {
+		const std::size_t w = writeIndex_.load(std::memory_order_acquire);
+		const std::size_t count = std::min(n, std::min(w - r, capacity_));
+		const std::size_t first = w - count;
+
+		View view = makeView(first, count);
+		std::memcpy(dest, view.first.data, view.first.size * sizeof(T));
+		std::memcpy(dest + view.first.size, view.second.data, view.second.size * sizeof(T));
+
+		// Check if the producer has overwritten, or was overwriting,
+		// the elements during the copy.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (pendingWriteIndex_.load(std::memory_order_relaxed) - first <= capacity_) {
+			readIndex_.store(w, std::memory_order_release);
+			return count;
+		}
+	}
+	return 0;
+}
+
+template<typename T>
+void
+SPSCQueue<T>::reset()
+{
+	writeIndex_.store(0, std::memory_order_relaxed);
+	readIndex_.store(0, std::memory_order_relaxed);
+	pendingWriteIndex_.store(0, std::memory_order_relaxed);
+}
+
+} /* namespace GS */
+
+#endif // SPSC_QUEUE_H
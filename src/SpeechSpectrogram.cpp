@@ -0,0 +1,234 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "SpeechSpectrogram.h"
+
+#include <algorithm> /* max, max_element, min */
+#include <cmath> /* cos, rint */
+#include <memory>
+#include <utility> /* make_pair, move */
+
+#include "SignalDFT.h"
+#include "SpectrumKernels.h"
+
+#define WINDOW_DURATION_MS (8.0)
+#define HOP_DURATION_MS (1.0)
+#define MAX_FREQ (5500.0)
+#define NUM_ROWS (128U)
+#define DB_RANGE (70.0)
+#define NUM_COLORS (256)
+
+
+
+namespace GS {
+
+struct SpeechSpectrogram::Analysis {
+	std::vector<float> signal;
+	unsigned int windowSize;
+	unsigned int hopSize;
+	unsigned int dftSize;
+	unsigned int numBins;
+	unsigned int numRows;
+	unsigned int numFrames;
+	double frameDuration;
+	double maxFreq;
+	std::vector<float> levelList; // dB, [frame * numRows + row]
+	// Level 0: [frame * numRows + row].
+	std::vector<std::vector<unsigned char>> pyramid;
+};
+
+// Called by the tasks of the job.
+void
+SpeechSpectrogram::analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+					const std::atomic<bool>& canceled)
+{
+	SignalDFT dft(analysis.dftSize);
+	std::vector<float> window(analysis.windowSize);
+	const double coef = 2.0 * M_PI / (analysis.windowSize - 1);
+	double windowSum = 0.0;
+	for (unsigned int i = 0; i < analysis.windowSize; ++i) {
+		window[i] = 0.5 * (1.0 - std::cos(coef * i)); // Hann
+		windowSum += window[i];
+	}
+	const float dftCoef = 2.0 / windowSum;
+	std::vector<float> frame(analysis.windowSize);
+	std::vector<float> spectrum(dft.outputSize());
+	const long signalSize = analysis.signal.size();
+
+	for (unsigned int f = firstFrame; f < endFrame && !canceled; ++f) {
+		// The window is centered in the frame.
+		const long start = static_cast<long>(f) * analysis.hopSize + analysis.hopSize / 2 - analysis.windowSize / 2;
+		for (unsigned int i = 0; i < analysis.windowSize; ++i) {
+			const long pos = start + i;
+			frame[i] = (pos >= 0 && pos < signalSize) ? analysis.signal[pos] * window[i] : 0.0f;
+		}
+		dft.executePower(&frame[0], analysis.windowSize, &spectrum[0]); // zero padding
+
+		// Each row keeps the peak of its bins.
+		float* levels = &analysis.levelList[static_cast<std::size_t>(f) * analysis.numRows];
+		for (unsigned int row = 0; row < analysis.numRows; ++row) {
+			const unsigned int binBegin = row * analysis.numBins / analysis.numRows;
+			const unsigned int binEnd   = (row + 1U) * analysis.numBins / analysis.numRows;
+			float minValue;
+			SpectrumKernels::minMax(&spectrum[binBegin], binEnd - binBegin, minValue, levels[row]);
+		}
+		SpectrumKernels::powerToDecibel(levels, levels, analysis.numRows, dftCoef * dftCoef);
+	}
+}
+
+SpeechSpectrogram::SpeechSpectrogram(QObject* parent)
+		: QObject{parent}
+		, colorTable_(NUM_COLORS)
+{
+	// White -> black.
+	for (int i = 0; i < NUM_COLORS; ++i) {
+		const int v = NUM_COLORS - 1 - i;
+		colorTable_[i] = qRgb(v, v, v);
+	}
+}
+
+SpeechSpectrogram::~SpeechSpectrogram()
+{
+}
+
+void
+SpeechSpectrogram::compute(const std::vector<float>& signal, double sampleRate)
+{
+	clear();
+	if (signal.empty() || sampleRate <= 0.0) return;
+
+	auto analysis = std::make_unique<Analysis>();
+	analysis->signal = signal;
+	analysis->windowSize = std::max(static_cast<unsigned int>(std::rint(WINDOW_DURATION_MS * 1.0e-3 * sampleRate)), 2U);
+	analysis->hopSize = std::max(static_cast<unsigned int>(std::rint(HOP_DURATION_MS * 1.0e-3 * sampleRate)), 1U);
+	analysis->dftSize = 1;
+	while (analysis->dftSize < 2U * analysis->windowSize) { // zero padding
+		analysis->dftSize *= 2;
+	}
+	const double freqCoef = sampleRate / analysis->dftSize;
+	analysis->numBins = std::min(analysis->dftSize / 2U + 1U,
+				static_cast<unsigned int>(std::min(MAX_FREQ, 0.5 * sampleRate) / freqCoef) + 1U);
+	analysis->numRows = std::min(analysis->numBins, NUM_ROWS);
+	analysis->numFrames = (signal.size() + analysis->hopSize - 1U) / analysis->hopSize;
+	analysis->frameDuration = 1000.0 * analysis->hopSize / sampleRate;
+	analysis->maxFreq = (analysis->numBins - 1U) * freqCoef;
+	analysis->levelList.resize(static_cast<std::size_t>(analysis->numFrames) * analysis->numRows);
+
+	const unsigned int numFrames = analysis->numFrames;
+	job_.start(std::move(analysis), numFrames, &SpeechSpectrogram::analyzeFrames, &SpeechSpectrogram::buildPyramid,
+			[this]() { emit finished(); });
+}
+
+void
+SpeechSpectrogram::clear()
+{
+	job_.cancel();
+	tileCache_.clear();
+}
+
+// Called by the last task of the job.
+void
+SpeechSpectrogram::buildPyramid(Analysis& analysis)
+{
+	// Convert the levels to color indexes, relative to the maximum level.
+	const float maxLevel = *std::max_element(analysis.levelList.begin(), analysis.levelList.end());
+	const float minLevel = maxLevel - DB_RANGE;
+	const float colorCoef = (NUM_COLORS - 1) / DB_RANGE;
+	std::vector<unsigned char> level0(analysis.levelList.size());
+	for (std::size_t i = 0, size = level0.size(); i < size; ++i) {
+		level0[i] = static_cast<unsigned char>((std::max(analysis.levelList[i], minLevel) - minLevel) * colorCoef + 0.5f);
+	}
+	analysis.levelList = std::vector<float>();
+	analysis.pyramid.push_back(std::move(level0));
+
+	// Each level has half the columns of the previous one.
+	unsigned int numColumns = analysis.numFrames;
+	while (numColumns > TILE_WIDTH) {
+		const std::vector<unsigned char>& prev = analysis.pyramid.back();
+		const unsigned int prevNumColumns = numColumns;
+		numColumns = (numColumns + 1U) / 2U;
+		std::vector<unsigned char> level(static_cast<std::size_t>(numColumns) * analysis.numRows);
+		for (unsigned int c = 0; c < numColumns; ++c) {
+			const unsigned char* col1 = &prev[static_cast<std::size_t>(2U * c) * analysis.numRows];
+			const unsigned char* col2 = (2U * c + 1U < prevNumColumns) ? col1 + analysis.numRows : col1;
+			unsigned char* col = &level[static_cast<std::size_t>(c) * analysis.numRows];
+			for (unsigned int row = 0; row < analysis.numRows; ++row) {
+				col[row] = std::max(col1[row], col2[row]);
+			}
+		}
+		analysis.pyramid.push_back(std::move(level));
+	}
+}
+
+bool
+SpeechSpectrogram::ready() const
+{
+	return job_.ready();
+}
+
+double
+SpeechSpectrogram::frameDuration() const
+{
+	return job_.data()->frameDuration;
+}
+
+unsigned int
+SpeechSpectrogram::numFrames() const
+{
+	return job_.data()->numFrames;
+}
+
+unsigned int
+SpeechSpectrogram::numLevels() const
+{
+	return job_.data()->pyramid.size();
+}
+
+double
+SpeechSpectrogram::maxFreq() const
+{
+	return job_.data()->maxFreq;
+}
+
+const QImage&
+SpeechSpectrogram::tile(unsigned int level, unsigned int index)
+{
+	QImage& image = tileCache_[std::make_pair(level, index)];
+	if (!image.isNull()) return image;
+
+	const Analysis& analysis = *job_.data();
+	const unsigned int numColumns = (analysis.numFrames + (1U << level) - 1U) >> level;
+	const unsigned int firstColumn = index * TILE_WIDTH;
+	if (level >= analysis.pyramid.size() || firstColumn >= numColumns) {
+		return image;
+	}
+	const unsigned int width = std::min<unsigned int>(TILE_WIDTH, numColumns - firstColumn);
+	const unsigned int numRows = analysis.numRows;
+	image = QImage(width, numRows, QImage::Format_Indexed8);
+	image.setColorTable(colorTable_);
+	const std::vector<unsigned char>& data = analysis.pyramid[level];
+	for (unsigned int row = 0; row < numRows; ++row) {
+		uchar* line = image.scanLine(numRows - 1U - row);
+		for (unsigned int c = 0; c < width; ++c) {
+			line[c] = data[static_cast<std::size_t>(firstColumn + c) * numRows + row];
+		}
+	}
+	return image;
+}
+
+} // namespace GS
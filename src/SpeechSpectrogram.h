@@ -0,0 +1,87 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef SPEECH_SPECTROGRAM_H
+#define SPEECH_SPECTROGRAM_H
+
+#include <atomic>
+#include <map>
+#include <utility> /* pair */
+#include <vector>
+
+#include <QImage>
+#include <QObject>
+#include <QVector>
+
+#include "FrameRangeJob.h"
+
+
+
+namespace GS {
+
+// Spectrogram of a synthesized utterance.
+//
+// The STFT frames are computed in a FrameRangeJob. Then a pyramid of levels
+// is built: level 0 has one column per frame, and each of the next levels
+// halves the number of columns (keeping the maximum values).
+//
+// The images are created on demand as tiles of TILE_WIDTH columns and are
+// cached, so zooming and scrolling don't need to compute the DFTs again.
+class SpeechSpectrogram : public QObject {
+	Q_OBJECT
+public:
+	enum {
+		TILE_WIDTH = 256 // columns
+	};
+
+	explicit SpeechSpectrogram(QObject* parent=nullptr);
+	virtual ~SpeechSpectrogram();
+
+	// Starts the computation. Cancels the previous computation.
+	void compute(const std::vector<float>& signal, double sampleRate);
+	void clear();
+
+	// The functions below must be called only if ready() returns true.
+	bool ready() const;
+	double frameDuration() const; // ms
+	unsigned int numFrames() const;
+	unsigned int numLevels() const;
+	double maxFreq() const; // Hz
+	// The lowest frequency is at the bottom of the image.
+	const QImage& tile(unsigned int level, unsigned int index);
+signals:
+	// Emitted from a thread of the pool.
+	void finished();
+private:
+	struct Analysis;
+
+	SpeechSpectrogram(const SpeechSpectrogram&) = delete;
+	SpeechSpectrogram& operator=(const SpeechSpectrogram&) = delete;
+
+	static void analyzeFrames(Analysis& analysis, unsigned int firstFrame, unsigned int endFrame,
+					const std::atomic<bool>& canceled);
+	static void buildPyramid(Analysis& analysis);
+
+	FrameRangeJob<Analysis> job_;
+	std::map<std::pair<unsigned int, unsigned int>, QImage> tileCache_; // key: (level, index)
+	QVector<QRgb> colorTable_;
+};
+
+} // namespace GS
+
+#endif // SPEECH_SPECTROGRAM_H
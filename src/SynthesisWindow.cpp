@@ -441,7 +441,10 @@ SynthesisWindow::handleAudioFinished()
 	} else {
 		setSpeechSignal(*synthesis_->vtmController);
 	}
-	ui_->parameterWidget->update();
+	ui_->parameterWidget->updateSpeechSignal();
+	if (!synthesis_->refVtmController) {
+		emit speechSignalUpdated(speechSignal_, speechSamplerate_);
+	}
 
 	enableProcessingButtons();
 	emit synthesisFinished();
@@ -53,6 +53,8 @@ signals:
 	void playAudioRequested(double sampleRate);
 	void synthesisStarted();
 	void synthesisFinished();
+	// Emitted after the speech synthesized with the main model has been played.
+	void speechSignalUpdated(const std::vector<float>& signal, double sampleRate);
 public slots:
 	void setupParameterTable();
 	void synthesizeWithManualIntonation();
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "VocalTractModelPool.h"
+
+#include <iostream>
+#include <utility> /* move */
+
+#include "ConfigurationData.h"
+#include "Log.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Constructor.
+ */
+VocalTractModelPool::VocalTractModelPool(bool interactive, std::size_t maxConfigurations,
+						std::size_t maxInstancesPerConfiguration)
+		: interactive_{interactive}
+		, maxConfigurations_{maxConfigurations}
+		, maxInstancesPerConfiguration_{maxInstancesPerConfiguration}
+{
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+VocalTractModelPool::~VocalTractModelPool()
+{
+}
+
+/*******************************************************************************
+ *
+ */
+VocalTractModelPool::Entry*
+VocalTractModelPool::findEntry(const std::string& key)
+{
+	for (auto iter = entryList_.begin(); iter != entryList_.end(); ++iter) {
+		if (iter->key == key) {
+			entryList_.splice(entryList_.begin(), entryList_, iter);
+			return &entryList_.front();
+		}
+	}
+	return nullptr;
+}
+
+/*******************************************************************************
+ *
+ */
+VocalTractModelPool::Entry&
+VocalTractModelPool::entry(const std::string& key)
+{
+	Entry* e = findEntry(key);
+	if (e) return *e;
+
+	if (entryList_.size() >= maxConfigurations_) {
+		entryList_.pop_back();
+	}
+	entryList_.emplace_front();
+	entryList_.front().key = key;
+	return entryList_.front();
+}
+
+/*******************************************************************************
+ *
+ */
+std::unique_ptr<VTM::VocalTractModel>
+VocalTractModelPool::acquire(const std::string& key, const ConfigurationData& data)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// A miss does not add the key, so that it does not remove
+		// the instances of other keys.
+		Entry* e = findEntry(key);
+		if (e && !e->freeList.empty()) {
+			std::unique_ptr<VTM::VocalTractModel> vtm = std::move(e->freeList.back());
+			e->freeList.pop_back();
+			return vtm;
+		}
+	}
+
+	if (Log::debugEnabled) std::cout << "[VocalTractModelPool] Creating new instance (key: " << key << ")." << std::endl;
+
+	return VTM::VocalTractModel::getInstance(data, interactive_);
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VocalTractModelPool::release(const std::string& key, std::unique_ptr<VTM::VocalTractModel> vtm)
+{
+	if (!vtm) return;
+
+	vtm->reset();
+	vtm->outputBuffer().clear();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Entry& e = entry(key);
+	if (e.freeList.size() < maxInstancesPerConfiguration_) {
+		e.freeList.push_back(std::move(vtm));
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VocalTractModelPool::prepare(const std::string& key, const ConfigurationData& data, std::size_t numInstances)
+{
+	if (numInstances > maxInstancesPerConfiguration_) {
+		numInstances = maxInstancesPerConfiguration_;
+	}
+
+	std::size_t numFree;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		numFree = entry(key).freeList.size();
+	}
+
+	// The instances are created without locking the mutex.
+	for ( ; numFree < numInstances; ++numFree) {
+		release(key, VTM::VocalTractModel::getInstance(data, interactive_));
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VocalTractModelPool::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	entryList_.clear();
+}
+
+} /* namespace GS */
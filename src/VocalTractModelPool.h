@@ -0,0 +1,85 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef VOCAL_TRACT_MODEL_POOL_H
+#define VOCAL_TRACT_MODEL_POOL_H
+
+#include <cstddef> /* std::size_t */
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "VocalTractModel.h"
+
+
+
+namespace GS {
+
+class ConfigurationData;
+
+// Keeps initialized vocal tract model instances, so that an instance can be
+// reused without new memory allocations.
+//
+// The instances are grouped by a key that must identify the configuration
+// data (including the output rate) used to create them.
+//
+// This class is thread-safe, but must not be used by the realtime threads.
+class VocalTractModelPool {
+public:
+	VocalTractModelPool(bool interactive, std::size_t maxConfigurations, std::size_t maxInstancesPerConfiguration);
+	~VocalTractModelPool();
+
+	// Returns a free instance, or a new one if the pool has no free
+	// instances for the key.
+	std::unique_ptr<VTM::VocalTractModel> acquire(const std::string& key, const ConfigurationData& data);
+
+	// Resets the state of the instance and keeps it in the pool.
+	void release(const std::string& key, std::unique_ptr<VTM::VocalTractModel> vtm);
+
+	// Creates instances until the pool has numInstances free instances for the key.
+	void prepare(const std::string& key, const ConfigurationData& data, std::size_t numInstances);
+
+	// Destroys all the free instances.
+	void clear();
+private:
+	struct Entry {
+		std::string key;
+		std::vector<std::unique_ptr<VTM::VocalTractModel>> freeList;
+	};
+
+	VocalTractModelPool(const VocalTractModelPool&) = delete;
+	VocalTractModelPool& operator=(const VocalTractModelPool&) = delete;
+
+	// The mutex must be locked.
+	// Returns null if the key is not in the pool.
+	Entry* findEntry(const std::string& key);
+	// The mutex must be locked.
+	// Adds the key if it is not in the pool.
+	Entry& entry(const std::string& key);
+
+	bool interactive_;
+	std::size_t maxConfigurations_;
+	std::size_t maxInstancesPerConfiguration_;
+	std::list<Entry> entryList_; // the most recently used entry is at the front
+	std::mutex mutex_;
+};
+
+} /* namespace GS */
+
+#endif // VOCAL_TRACT_MODEL_POOL_H
@@ -17,17 +17,24 @@
 
 #include "AnalysisWindow.h"
 
+#include <algorithm> /* max, min, sort, unique */
 #include <cassert>
-#include <cmath> /* abs, cos, log10 */
+#include <cmath> /* abs, cos */
+#include <utility> /* move */
 
 #include <QStringList>
 #include <QTimer>
 
-#include "JackRingbuffer.h"
+#include "FFTWPlanner.h"
 #include "SignalDFT.h"
+#include "SpectrumAverager.h"
+#include "SpectrumKernels.h"
+#include "SPSCQueue.h"
 #include "ui_AnalysisWindow.h"
 
-#define TIMER_INTERVAL_MS 500
+#define TIMER_INTERVAL_MS 40
+#define FFTW_PLANNER_FLAGS FFTW_MEASURE
+#define EXPONENTIAL_AVERAGING_TIME_CONSTANT_SEC 0.5
 
 
 
@@ -41,6 +48,13 @@ enum WindowType {
 	WINDOW_BLACKMAN
 };
 
+enum AveragingType {
+	AVERAGING_NONE,
+	AVERAGING_WELCH,
+	AVERAGING_EXPONENTIAL,
+	AVERAGING_PEAK_HOLD
+};
+
 constexpr int CURSOR_FREQ_STEP = 1;
 constexpr unsigned int FREQ_1 = 100;
 constexpr unsigned int FREQ_STEP_1 = 100;
@@ -50,7 +64,10 @@ constexpr int MAX_DB = -20;
 constexpr int MIN_DB = -120;
 constexpr int DB_STEP = 10;
 constexpr unsigned int MIN_WINDOW_SIZE = 32;
-constexpr unsigned int FFT_SIZE = 65536;
+constexpr unsigned int MAX_ZERO_PADDING_FACTOR = 8;
+constexpr unsigned int MAX_HOP_DIVISOR = 8; // 87.5% overlap
+constexpr int SPECTROGRAM_NUM_COLUMNS = 512;
+constexpr unsigned int SPECTROGRAM_MAX_ROWS = 512;
 
 } /* namespace */
 
@@ -60,11 +77,16 @@ AnalysisWindow::AnalysisWindow(QWidget *parent)
 		: QWidget{parent}
 		, ui_{std::make_unique<Ui::AnalysisWindow>()}
 		, sampleRate_{}
-		, analysisRingbuffer_{}
-		, analysisRingbufferNumSamples_{}
+		, analysisQueue_{}
+		, analysisQueueNumSamples_{}
 		, timer_{new QTimer(this)}
 		, state_{State::stopped}
-		, signalDFT_{std::make_unique<SignalDFT>(FFT_SIZE)}
+		, historyPos_{}
+		, historyCount_{}
+		, historyTotal_{}
+		, signalDFT_{}
+		, spectrogramSettings_{}
+		, nextFrameEnd_{}
 {
 	ui_->setupUi(this);
 
@@ -80,7 +102,7 @@ AnalysisWindow::AnalysisWindow(QWidget *parent)
 	ui_->spectrumPlot->graph(1)->setAntialiased(false);
 
 	QStringList viewComboItems;
-	viewComboItems << tr("Spectrum") << tr("Signal");
+	viewComboItems << tr("Spectrum") << tr("Signal") << tr("Spectrogram");
 	ui_->viewComboBox->addItems(viewComboItems);
 
 	QStringList yAxisComboItems;
@@ -99,7 +121,23 @@ AnalysisWindow::AnalysisWindow(QWidget *parent)
 	ui_->windowTypeComboBox->addItem(tr("Blackman")   , WINDOW_BLACKMAN);
 	ui_->windowTypeComboBox->setCurrentIndex(ui_->windowTypeComboBox->count() - 1);
 
+	for (unsigned int factor = 1; factor <= MAX_ZERO_PADDING_FACTOR; factor *= 2) {
+		ui_->zeroPaddingComboBox->addItem(QString("%1x").arg(factor), factor);
+	}
+
+	for (unsigned int divisor = 1; divisor <= MAX_HOP_DIVISOR; divisor *= 2) {
+		ui_->overlapComboBox->addItem(QString("%1%").arg(100.0 * (divisor - 1) / divisor), divisor);
+	}
+	ui_->overlapComboBox->setCurrentIndex(ui_->overlapComboBox->count() - 2);
+
+	ui_->averagingComboBox->addItem(tr("None")       , AVERAGING_NONE);
+	ui_->averagingComboBox->addItem(tr("Welch")      , AVERAGING_WELCH);
+	ui_->averagingComboBox->addItem(tr("Exponential"), AVERAGING_EXPONENTIAL);
+	ui_->averagingComboBox->addItem(tr("Peak hold")  , AVERAGING_PEAK_HOLD);
+
 	ui_->cursorFreqSpinBox->setSingleStep(CURSOR_FREQ_STEP);
+
+	ui_->spectrogramWidget->hide();
 }
 
 AnalysisWindow::~AnalysisWindow()
@@ -107,31 +145,48 @@ AnalysisWindow::~AnalysisWindow()
 }
 
 void
-AnalysisWindow::setData(unsigned int sampleRate, JackRingbuffer* analysisRingbuffer, size_t analysisRingbufferNumSamples)
+AnalysisWindow::setData(unsigned int sampleRate, SPSCQueue<jack_default_audio_sample_t>* analysisQueue, size_t analysisQueueNumSamples)
 {
-	if (analysisRingbufferNumSamples > 0 && analysisRingbufferNumSamples != FFT_SIZE) {
-		THROW_EXCEPTION(InvalidValueException, "Invalid ring buffer size: " << analysisRingbufferNumSamples <<
-				" (should be " << FFT_SIZE << ").");
+	if (analysisQueueNumSamples > 0 && analysisQueueNumSamples < MIN_WINDOW_SIZE) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid queue size: " << analysisQueueNumSamples <<
+				" (should be at least " << MIN_WINDOW_SIZE << ").");
 	}
 
 	sampleRate_ = sampleRate;
-	analysisRingbuffer_ = analysisRingbuffer;
-	analysisRingbufferNumSamples_ = analysisRingbufferNumSamples;
+	analysisQueue_ = analysisQueue;
+	analysisQueueNumSamples_ = analysisQueueNumSamples;
 
 	ui_->sampleRateLabel->setText(QString::number(sampleRate_));
 
-	signal_.resize(analysisRingbufferNumSamples_);
-	plotX_.reserve(analysisRingbufferNumSamples_);
-	plotY_.reserve(analysisRingbufferNumSamples_);
+	history_.assign(analysisQueueNumSamples_, 0.0);
+	historyPos_ = 0;
+	historyCount_ = 0;
+	historyTotal_ = 0;
+	spectrogramSettings_ = SpectrogramSettings{};
+	if (analysisQueueNumSamples_ > 0) {
+		spectrumAverager_ = std::make_unique<SpectrumAverager>(analysisQueueNumSamples_);
+	} else {
+		spectrumAverager_.reset();
+	}
+	newSamples_.resize(analysisQueueNumSamples_);
+	signal_.resize(analysisQueueNumSamples_);
+	plotX_.reserve(analysisQueueNumSamples_);
+	plotY_.reserve(analysisQueueNumSamples_);
 
 	ui_->windowSizeComboBox->clear();
-	if (analysisRingbufferNumSamples_ > 0) {
+	if (analysisQueueNumSamples_ > 0) {
 		unsigned int windowSize = MIN_WINDOW_SIZE;
-		while (windowSize <= analysisRingbufferNumSamples_) {
+		while (windowSize <= analysisQueueNumSamples_) {
 			ui_->windowSizeComboBox->addItem(QString::number(windowSize), windowSize);
 			windowSize *= 2;
 		}
 		ui_->windowSizeComboBox->setCurrentIndex(ui_->windowSizeComboBox->count() - 1);
+
+		// Prepare the plans for the DFT sizes that can be selected.
+		std::vector<unsigned int> sizeList = dftSizeList();
+		if (!fftwPlanner_ || fftwPlanner_->sizeList() != sizeList) {
+			fftwPlanner_ = std::make_unique<FFTWPlanner>(std::move(sizeList), FFTW_PLANNER_FLAGS);
+		}
 	}
 
 	ui_->maxFreqComboBox->clear();
@@ -167,6 +222,9 @@ void
 AnalysisWindow::on_startStopButton_clicked()
 {
 	if (state_ == State::stopped) {
+		if (spectrumAverager_) {
+			spectrumAverager_->restart();
+		}
 		timer_->start();
 		ui_->startStopButton->setText(tr("Stop"));
 		state_ = State::enabled;
@@ -190,29 +248,49 @@ AnalysisWindow::on_windowSizeComboBox_currentIndexChanged(int /*index*/)
 void
 AnalysisWindow::on_cursorFreqSpinBox_valueChanged(double /*d*/)
 {
-	if (sampleRate_ == 0 || !analysisRingbuffer_) {
+	if (sampleRate_ == 0 || !analysisQueue_) {
 		return;
 	}
 
 	plotCursor();
 }
 
+void
+AnalysisWindow::on_viewComboBox_currentIndexChanged(int index)
+{
+	const bool spectrogramView = (index == 2);
+	ui_->spectrumPlot->setVisible(!spectrogramView);
+	ui_->spectrogramWidget->setVisible(spectrogramView);
+
+	// Restart the spectrogram.
+	spectrogramSettings_ = SpectrogramSettings{};
+
+	if (spectrumAverager_) {
+		spectrumAverager_->restart();
+	}
+}
+
+void
+AnalysisWindow::on_averagingComboBox_currentIndexChanged(int /*index*/)
+{
+	if (spectrumAverager_) {
+		spectrumAverager_->restart();
+	}
+}
+
 // Slot.
 void
 AnalysisWindow::showData()
 {
-	if (sampleRate_ == 0 || !analysisRingbuffer_) {
+	if (sampleRate_ == 0 || !analysisQueue_) {
 		stop();
 		return;
 	}
 
 	assert(!signal_.empty());
-	assert(signal_.size() == analysisRingbufferNumSamples_);
+	assert(signal_.size() == analysisQueueNumSamples_);
 
-	const size_t bufferSize = analysisRingbufferNumSamples_ * sizeof(jack_default_audio_sample_t);
-	if (analysisRingbuffer_->readSpace() < bufferSize) {
-		return;
-	}
+	readQueue();
 
 	if (ui_->windowSizeComboBox->currentIndex() < 0) {
 		return;
@@ -229,68 +307,136 @@ AnalysisWindow::showData()
 	}
 	const double minDecibelLevel = ui_->minDecibelLevelComboBox->itemData(ui_->minDecibelLevelComboBox->currentIndex()).toDouble();
 
+	if (ui_->zeroPaddingComboBox->currentIndex() < 0) {
+		return;
+	}
+	const unsigned int zeroPaddingFactor = ui_->zeroPaddingComboBox->itemData(ui_->zeroPaddingComboBox->currentIndex()).toUInt();
+
 	const bool logYAxis = (ui_->yAxisComboBox->currentIndex() == 0);
 	const bool spectrumView = (ui_->viewComboBox->currentIndex() == 0);
+	const bool spectrogramView = (ui_->viewComboBox->currentIndex() == 2);
+
+	if (spectrogramView) {
+		updateSpectrogram(windowSize, zeroPaddingFactor, maxFreq, minDecibelLevel);
+		return;
+	}
 
-	// Read data from JACK ringbuffer.
-	size_t bytesRead = analysisRingbuffer_->peek(reinterpret_cast<char*>(&signal_[0]), bufferSize);
-	assert(bytesRead == bufferSize);
-	analysisRingbuffer_->advanceRead(bytesRead);
-
-	// Normalize.
-	jack_default_audio_sample_t maxValue = 0.0;
-	for (const auto& sample : signal_) {
-		const jack_default_audio_sample_t absValue = std::abs(sample);
-		if (absValue > maxValue) maxValue = absValue;
-	}
-	if (maxValue > 0.0) {
-		const jack_default_audio_sample_t normCoef = 1.0 / maxValue;
-		for (auto& sample : signal_) {
-			sample *= normCoef;
+	if (spectrumView && ui_->averagingComboBox->currentIndex() > 0) {
+		if (!updateAveragedSpectrum(windowSize, zeroPaddingFactor, logYAxis, maxFreq)) {
+			return;
 		}
+		showPlot(spectrumView, logYAxis, maxFreq, minDecibelLevel);
+		return;
+	}
+
+	// Analyze the most recent samples.
+	if (historyCount_ < windowSize) {
+		return;
 	}
+	copyHistory(windowSize);
+
+	SpectrumKernels::normalize(&signal_[0], windowSize);
 
 	if (spectrumView) {
-		assert(signalDFT_);
 		assert(window_.size() == windowSize);
 
-		for (unsigned int i = 0; i < windowSize; ++i) {
-			signal_[i] *= window_[i];
+		SpectrumKernels::multiply(&signal_[0], &window_[0], windowSize);
+
+		SignalDFT* dft = signalDFT(windowSize * zeroPaddingFactor);
+		if (!dft) {
+			return;
 		}
-		for (unsigned int i = windowSize; i < FFT_SIZE; ++i) { // padding
-			signal_[i] = 0.0;
+		signalDFT_ = dft;
+		if (fftwPlanner_ && fftwPlanner_->ready()) {
+			signalDFT_->upgradePlan(fftwPlanner_->flags());
 		}
-
 		const unsigned int spectrumSize = signalDFT_->outputSize();
-		plotX_.resize(spectrumSize);
-		plotY_.resize(spectrumSize);
+		spectrum_.resize(spectrumSize);
 
-		signalDFT_->execute(&signal_[0], plotY_.data());
-
-		const double freqCoef = static_cast<double>(sampleRate_) / signalDFT_->size();
-		const double dftCoef = 1.0 / signalDFT_->size();
+		// The level does not depend on the zero padding.
+		const float dftCoef = 1.0f / windowSize;
 		if (logYAxis) {
-			for (unsigned int i = 0; i < spectrumSize; ++i) {
-				plotX_[i] = i * freqCoef;
-				plotY_[i] = 20.0 * std::log10(plotY_[i] * dftCoef);
-			}
+			signalDFT_->executePower(&signal_[0], windowSize, &spectrum_[0]); // zero padding
+			SpectrumKernels::powerToDecibel(&spectrum_[0], &spectrum_[0], spectrumSize, dftCoef * dftCoef);
 		} else {
-			for (unsigned int i = 0; i < spectrumSize; ++i) {
-				plotX_[i] = i * freqCoef;
-				plotY_[i] *= dftCoef;
-			}
+			signalDFT_->execute(&signal_[0], windowSize, &spectrum_[0]); // zero padding
+			SpectrumKernels::scale(&spectrum_[0], spectrumSize, dftCoef);
 		}
+
+		const double freqCoef = static_cast<double>(sampleRate_) / signalDFT_->size();
+		// Only the visible bins.
+		const unsigned int numBins = std::min(spectrumSize, static_cast<unsigned int>(maxFreq / freqCoef) + 2U);
+		setPlotData(&spectrum_[0], numBins, freqCoef);
 	} else {
-		plotX_.resize(windowSize);
-		plotY_.resize(windowSize);
+		setPlotData(&signal_[0], windowSize, 1.0);
+	}
 
-		for (unsigned int i = 0; i < windowSize; ++i) {
-			plotX_[i] = i;
-			plotY_[i] = signal_[i];
-		}
+	showPlot(spectrumView, logYAxis, maxFreq, minDecibelLevel);
+}
+
+bool
+AnalysisWindow::updateAveragedSpectrum(unsigned int windowSize, unsigned int zeroPaddingFactor, bool logYAxis, double maxFreq)
+{
+	if (ui_->overlapComboBox->currentIndex() < 0) {
+		return false;
+	}
+	const unsigned int hopDivisor = ui_->overlapComboBox->itemData(ui_->overlapComboBox->currentIndex()).toUInt();
+
+	SpectrumAverager::Settings settings;
+	switch (ui_->averagingComboBox->itemData(ui_->averagingComboBox->currentIndex()).toInt()) {
+	case AVERAGING_WELCH:
+		settings.mode = SpectrumAverager::Mode::welch;
+		break;
+	case AVERAGING_EXPONENTIAL:
+		settings.mode = SpectrumAverager::Mode::exponential;
+		break;
+	default:
+		settings.mode = SpectrumAverager::Mode::peakHold;
+	}
+	settings.dftSize = windowSize * zeroPaddingFactor;
+	settings.hopSize = windowSize / hopDivisor;
+	settings.sampleRate = sampleRate_;
+	settings.timeConstant = EXPONENTIAL_AVERAGING_TIME_CONSTANT_SEC;
+	settings.window = window_;
+	spectrumAverager_->setSettings(settings);
+	if (fftwPlanner_ && fftwPlanner_->ready()) {
+		spectrumAverager_->setPlanFlags(fftwPlanner_->flags());
+	}
+
+	if (!spectrumAverager_->getResult(spectrum_)) {
+		return false;
+	}
+	// The result may have been computed with the previous settings.
+	if (spectrum_.size() != settings.dftSize / 2U + 1U) {
+		spectrum_.clear();
+		return false;
 	}
 
-	ui_->spectrumPlot->graph(0)->setData(plotX_, plotY_);
+	SignalDFT* dft = signalDFT(settings.dftSize);
+	if (dft) {
+		signalDFT_ = dft; // used by the cursor
+	}
+	const unsigned int spectrumSize = spectrum_.size();
+
+	// The level does not depend on the zero padding.
+	const float dftCoef = 1.0f / windowSize;
+	if (logYAxis) {
+		SpectrumKernels::powerToDecibel(&spectrum_[0], &spectrum_[0], spectrumSize, dftCoef * dftCoef);
+	} else {
+		SpectrumKernels::squareRoot(&spectrum_[0], spectrumSize);
+		SpectrumKernels::scale(&spectrum_[0], spectrumSize, dftCoef);
+	}
+
+	const double freqCoef = static_cast<double>(sampleRate_) / settings.dftSize;
+	// Only the visible bins.
+	const unsigned int numBins = std::min(spectrumSize, static_cast<unsigned int>(maxFreq / freqCoef) + 2U);
+	setPlotData(&spectrum_[0], numBins, freqCoef);
+	return true;
+}
+
+void
+AnalysisWindow::showPlot(bool spectrumView, bool logYAxis, double maxFreq, double minDecibelLevel)
+{
 	ui_->spectrumPlot->graph(0)->rescaleAxes();
 	if (spectrumView) {
 		ui_->spectrumPlot->graph(0)->keyAxis()->setRange(0.0, maxFreq);
@@ -303,6 +449,76 @@ AnalysisWindow::showData()
 	plotCursor();
 }
 
+void
+AnalysisWindow::updateSpectrogram(unsigned int windowSize, unsigned int zeroPaddingFactor, double maxFreq, double minDecibelLevel)
+{
+	if (ui_->overlapComboBox->currentIndex() < 0) {
+		return;
+	}
+	const unsigned int hopDivisor = ui_->overlapComboBox->itemData(ui_->overlapComboBox->currentIndex()).toUInt();
+	const unsigned int hopSize = windowSize / hopDivisor;
+
+	SignalDFT* dftPtr = signalDFT(windowSize * zeroPaddingFactor);
+	if (!dftPtr) {
+		return;
+	}
+	SignalDFT& dft = *dftPtr;
+	if (fftwPlanner_ && fftwPlanner_->ready()) {
+		dft.upgradePlan(fftwPlanner_->flags());
+	}
+	const double freqCoef = static_cast<double>(sampleRate_) / dft.size();
+	const unsigned int numBins = std::min(dft.outputSize(), static_cast<unsigned int>(maxFreq / freqCoef) + 1U);
+	const unsigned int numRows = std::min(numBins, SPECTROGRAM_MAX_ROWS);
+
+	const SpectrogramSettings settings{windowSize, hopSize, dft.size(), maxFreq, minDecibelLevel};
+	if (!(settings == spectrogramSettings_)) {
+		spectrogramSettings_ = settings;
+		ui_->spectrogramWidget->reset(SPECTROGRAM_NUM_COLUMNS, numRows, (numBins - 1U) * freqCoef);
+		frameSpectrum_.resize(dft.outputSize());
+		spectrogramColumn_.resize(numRows);
+		nextFrameEnd_ = historyTotal_;
+	}
+
+	// Skip the frames that are no longer in the history,
+	// or that would not be visible.
+	const std::size_t firstAvailableFrameEnd = historyTotal_ - historyCount_ + windowSize;
+	const std::size_t maxDelay = static_cast<std::size_t>(hopSize) * (SPECTROGRAM_NUM_COLUMNS - 1);
+	if (historyTotal_ > maxDelay && nextFrameEnd_ < historyTotal_ - maxDelay) {
+		nextFrameEnd_ = historyTotal_ - maxDelay;
+	}
+	if (nextFrameEnd_ < firstAvailableFrameEnd) {
+		nextFrameEnd_ = firstAvailableFrameEnd;
+	}
+
+	assert(window_.size() == windowSize);
+	// The level does not depend on the zero padding.
+	const float dftCoef = 1.0f / windowSize;
+	const float levelCoef = 1.0f / -minDecibelLevel;
+	unsigned int numNewColumns = 0;
+	for ( ; nextFrameEnd_ <= historyTotal_; nextFrameEnd_ += hopSize, ++numNewColumns) {
+		copyHistory(windowSize, historyTotal_ - nextFrameEnd_);
+		SpectrumKernels::multiply(&signal_[0], &window_[0], windowSize);
+		dft.executePower(&signal_[0], windowSize, &frameSpectrum_[0]); // zero padding
+
+		// Each row shows the peak of its bins.
+		for (unsigned int row = 0; row < numRows; ++row) {
+			const unsigned int binBegin = static_cast<unsigned int>(static_cast<std::size_t>(row) * numBins / numRows);
+			const unsigned int binEnd   = static_cast<unsigned int>(static_cast<std::size_t>(row + 1U) * numBins / numRows);
+			float minValue, maxValue;
+			SpectrumKernels::minMax(&frameSpectrum_[binBegin], binEnd - binBegin, minValue, maxValue);
+			spectrogramColumn_[row] = maxValue;
+		}
+		SpectrumKernels::powerToDecibel(&spectrogramColumn_[0], &spectrogramColumn_[0], numRows, dftCoef * dftCoef);
+		for (unsigned int row = 0; row < numRows; ++row) {
+			spectrogramColumn_[row] = std::max(0.0f, std::min((spectrogramColumn_[row] - static_cast<float>(minDecibelLevel)) * levelCoef, 1.0f));
+		}
+		ui_->spectrogramWidget->addColumn(&spectrogramColumn_[0]);
+	}
+	if (numNewColumns > 0) {
+		ui_->spectrogramWidget->update();
+	}
+}
+
 void
 AnalysisWindow::setupWindow()
 {
@@ -380,23 +596,113 @@ AnalysisWindow::plotCursor()
 	QCPRange yRange = ui_->spectrumPlot->graph(1)->valueAxis()->range();
 	QVector<double> cursorY = {yRange.lower, yRange.upper};
 
-	ui_->spectrumPlot->graph(1)->setData(cursorX, cursorY);
+	ui_->spectrumPlot->graph(1)->setSortedData(cursorX, cursorY);
 	ui_->spectrumPlot->replot();
 
 	// Show value at cursor.
-	assert(signalDFT_);
+	if (!signalDFT_) {
+		ui_->valueAtCursorLabel->clear();
+		return;
+	}
 	const double freqCoef = static_cast<double>(sampleRate_) / signalDFT_->size();
 	const double cursorFreqPos = cursorFreq / freqCoef;
 	const unsigned int cursorFreqBaseIndex = static_cast<unsigned int>(cursorFreqPos);
 	const double k = cursorFreqPos - cursorFreqBaseIndex;
 	double cursorValue = 0.0;
-	const unsigned int spectrumSize = plotY_.size();
-	if (cursorFreqBaseIndex < spectrumSize - 1) {
-		cursorValue = plotY_[cursorFreqBaseIndex] * (1.0 - k) + plotY_[cursorFreqBaseIndex + 1] * k;
-	} else if (cursorFreqBaseIndex == spectrumSize - 1) {
-		cursorValue = plotY_[cursorFreqBaseIndex];
+	const unsigned int spectrumSize = spectrum_.size();
+	if (cursorFreqBaseIndex + 1U < spectrumSize) {
+		cursorValue = spectrum_[cursorFreqBaseIndex] * (1.0 - k) + spectrum_[cursorFreqBaseIndex + 1U] * k;
+	} else if (cursorFreqBaseIndex + 1U == spectrumSize) {
+		cursorValue = spectrum_[cursorFreqBaseIndex];
 	}
 	ui_->valueAtCursorLabel->setText(QString::number(cursorValue, 'f', 3));
 }
 
+void
+AnalysisWindow::setPlotData(const float* data, unsigned int n, double xCoef)
+{
+	const unsigned int numColumns = std::max(ui_->spectrumPlot->axisRect()->width(), 1);
+	if (n <= 2U * numColumns) {
+		plotX_.resize(n);
+		plotY_.resize(n);
+		for (unsigned int i = 0; i < n; ++i) {
+			plotX_[i] = i * xCoef;
+			plotY_[i] = data[i];
+		}
+	} else {
+		// One min/max pair per pixel column.
+		plotX_.resize(2U * numColumns);
+		plotY_.resize(2U * numColumns);
+		for (unsigned int c = 0; c < numColumns; ++c) {
+			const unsigned int begin = static_cast<unsigned int>(static_cast<std::size_t>(c) * n / numColumns);
+			const unsigned int end   = static_cast<unsigned int>(static_cast<std::size_t>(c + 1U) * n / numColumns);
+			float minValue, maxValue;
+			SpectrumKernels::minMax(data + begin, end - begin, minValue, maxValue);
+			plotX_[2U * c] = plotX_[2U * c + 1U] = begin * xCoef;
+			plotY_[2U * c] = minValue;
+			plotY_[2U * c + 1U] = maxValue;
+		}
+	}
+	ui_->spectrumPlot->graph(0)->setSortedData(plotX_, plotY_);
+}
+
+SignalDFT*
+AnalysisWindow::signalDFT(unsigned int size)
+{
+	std::unique_ptr<SignalDFT>& dft = signalDFTCache_[size];
+	if (!dft) {
+		dft = SignalDFT::tryCreate(size);
+	}
+	return dft.get();
+}
+
+std::vector<unsigned int>
+AnalysisWindow::dftSizeList() const
+{
+	std::vector<unsigned int> sizeList;
+	for (int i = 0, count = ui_->windowSizeComboBox->count(); i < count; ++i) {
+		const unsigned int windowSize = ui_->windowSizeComboBox->itemData(i).toUInt();
+		for (int j = 0, paddingCount = ui_->zeroPaddingComboBox->count(); j < paddingCount; ++j) {
+			sizeList.push_back(windowSize * ui_->zeroPaddingComboBox->itemData(j).toUInt());
+		}
+	}
+	std::sort(sizeList.begin(), sizeList.end());
+	sizeList.erase(std::unique(sizeList.begin(), sizeList.end()), sizeList.end());
+	return sizeList;
+}
+
+void
+AnalysisWindow::readQueue()
+{
+	const std::size_t n = analysisQueue_->popLatest(newSamples_.data(), newSamples_.size());
+	const std::size_t historySize = history_.size();
+	for (std::size_t i = 0; i < n; ++i) {
+		history_[historyPos_] = newSamples_[i];
+		if (++historyPos_ == historySize) {
+			historyPos_ = 0;
+		}
+	}
+	historyCount_ = std::min(historyCount_ + n, historySize);
+	historyTotal_ += n;
+
+	// The averager analyzes all the samples.
+	if (spectrumAverager_ && ui_->viewComboBox->currentIndex() == 0 && ui_->averagingComboBox->currentIndex() > 0) {
+		spectrumAverager_->push(newSamples_.data(), n);
+	}
+}
+
+void
+AnalysisWindow::copyHistory(std::size_t n, std::size_t offset)
+{
+	assert(n + offset <= historyCount_);
+	const std::size_t historySize = history_.size();
+	std::size_t pos = (historyPos_ + 2U * historySize - n - offset) % historySize;
+	for (std::size_t i = 0; i < n; ++i) {
+		signal_[i] = history_[pos];
+		if (++pos == historySize) {
+			pos = 0;
+		}
+	}
+}
+
 } /* namespace GS */
@@ -18,6 +18,7 @@
 #ifndef ANALYSIS_WINDOW_H
 #define ANALYSIS_WINDOW_H
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -36,8 +37,10 @@ class AnalysisWindow;
 
 namespace GS {
 
-class JackRingbuffer;
+class FFTWPlanner;
 class SignalDFT;
+class SpectrumAverager;
+template<typename T> class SPSCQueue;
 
 class AnalysisWindow : public QWidget {
 	Q_OBJECT
@@ -45,13 +48,15 @@ public:
 	explicit AnalysisWindow(QWidget* parent=0);
 	~AnalysisWindow();
 
-	void setData(unsigned int sampleRate, JackRingbuffer* analysisRingbuffer, size_t analysisRingbufferNumSamples);
+	void setData(unsigned int sampleRate, SPSCQueue<jack_default_audio_sample_t>* analysisQueue, size_t analysisQueueNumSamples);
 	void stop();
 private slots:
 	void on_startStopButton_clicked();
 	void on_windowTypeComboBox_currentIndexChanged(int index);
 	void on_windowSizeComboBox_currentIndexChanged(int index);
 	void on_cursorFreqSpinBox_valueChanged(double d);
+	void on_viewComboBox_currentIndexChanged(int index);
+	void on_averagingComboBox_currentIndexChanged(int index);
 	void showData();
 private:
 	enum class State {
@@ -59,20 +64,66 @@ private:
 		enabled
 	};
 
+	struct SpectrogramSettings {
+		unsigned int windowSize;
+		unsigned int hopSize;
+		unsigned int dftSize;
+		double maxFreq;
+		double minDecibelLevel;
+		bool operator==(const SpectrogramSettings& o) const {
+			return windowSize == o.windowSize && hopSize == o.hopSize && dftSize == o.dftSize &&
+				maxFreq == o.maxFreq && minDecibelLevel == o.minDecibelLevel;
+		}
+	};
+
 	void setupWindow();
 	void plotCursor();
+	// Sets the data of the main graph, reducing it to one min/max pair
+	// per pixel column if necessary. x[i] = i * xCoef.
+	void setPlotData(const float* data, unsigned int n, double xCoef);
+	// Gets the spectrum accumulated by the averager since the last update.
+	// Returns false if there is no new data.
+	bool updateAveragedSpectrum(unsigned int windowSize, unsigned int zeroPaddingFactor, bool logYAxis, double maxFreq);
+	void showPlot(bool spectrumView, bool logYAxis, double maxFreq, double minDecibelLevel);
+	// Adds the STFT frames that are complete since the last update.
+	void updateSpectrogram(unsigned int windowSize, unsigned int zeroPaddingFactor, double maxFreq, double minDecibelLevel);
+	// Moves the new samples from the analysis queue to the history.
+	void readQueue();
+	// Copies n samples of the history to signal_. The last sample copied is
+	// the one that precedes the most recent sample by "offset" samples.
+	void copyHistory(std::size_t n, std::size_t offset=0);
+	// Returns the DFT of the specified size, creating it if necessary.
+	// Returns null if the DFT could not be created without waiting for
+	// other threads (e.g. the FFTW planner). The caller must retry later.
+	SignalDFT* signalDFT(unsigned int size);
+	// The DFT sizes that the combo boxes can produce, in increasing order.
+	std::vector<unsigned int> dftSizeList() const;
 
 	std::unique_ptr<Ui::AnalysisWindow> ui_;
 	unsigned int sampleRate_;
-	JackRingbuffer* analysisRingbuffer_;
-	size_t analysisRingbufferNumSamples_;
+	SPSCQueue<jack_default_audio_sample_t>* analysisQueue_;
+	size_t analysisQueueNumSamples_;
 	QTimer* timer_;
 	State state_;
+	// Circular buffer with the most recent samples.
+	std::vector<jack_default_audio_sample_t> history_;
+	std::size_t historyPos_; // next write position
+	std::size_t historyCount_; // number of valid samples
+	std::size_t historyTotal_; // number of samples received since setData
+	std::vector<jack_default_audio_sample_t> newSamples_;
 	std::vector<jack_default_audio_sample_t> signal_;
+	std::vector<float> spectrum_; // level in dB or linear, depending on the y-axis
 	QVector<double> plotX_;
 	QVector<double> plotY_;
-	std::unique_ptr<SignalDFT> signalDFT_;
-	std::vector<double> window_;
+	std::unique_ptr<FFTWPlanner> fftwPlanner_;
+	std::map<unsigned int, std::unique_ptr<SignalDFT>> signalDFTCache_; // key: DFT size
+	SignalDFT* signalDFT_; // the last used DFT
+	std::vector<float> window_;
+	std::unique_ptr<SpectrumAverager> spectrumAverager_;
+	SpectrogramSettings spectrogramSettings_;
+	std::size_t nextFrameEnd_; // the next STFT frame ends before this sample (absolute position)
+	std::vector<float> frameSpectrum_;
+	std::vector<float> spectrogramColumn_;
 };
 
 } /* namespace GS */
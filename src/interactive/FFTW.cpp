@@ -26,13 +26,21 @@ namespace GS {
 std::mutex FFTW::mutex_;
 
 FFTW::FFTW()
+		: ownsLock_{true}
 {
 	mutex_.lock();
 }
 
+FFTW::FFTW(std::try_to_lock_t)
+		: ownsLock_{mutex_.try_lock()}
+{
+}
+
 FFTW::~FFTW()
 {
-	mutex_.unlock();
+	if (ownsLock_) {
+		mutex_.unlock();
+	}
 }
 
 template<>
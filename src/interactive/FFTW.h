@@ -79,8 +79,14 @@ public:
 	};
 
 	FFTW();
+	// Does not wait if the mutex is locked by another thread.
+	// In this case, ownsLock() returns false and the instance
+	// must not be used.
+	explicit FFTW(std::try_to_lock_t);
 	~FFTW();
 
+	bool ownsLock() const { return ownsLock_; }
+
 	FFTWPlan plan_dft_r2c_1d(int n, float* in, fftwf_complex* out, unsigned int flags = 0) {
 		fftwf_plan p = fftwf_plan_dft_r2c_1d(n, in, out, flags);
 		if (p == nullptr) THROW_EXCEPTION(FFTWException, "Error in fftw_plan_dft_r2c_1d (float).");
@@ -131,6 +137,18 @@ public:
 		p.reset();
 	}
 
+	// Wisdom (float only).
+	bool import_wisdom_from_filename(const char* filePath) {
+		return fftwf_import_wisdom_from_filename(filePath) != 0;
+	}
+	bool export_wisdom_to_filename(const char* filePath) {
+		return fftwf_export_wisdom_to_filename(filePath) != 0;
+	}
+	// Limits the time spent by the planner with FFTW_MEASURE/FFTW_PATIENT (float only).
+	void set_timelimit(double seconds) {
+		fftwf_set_timelimit(seconds);
+	}
+
 	template<typename T> static T* alloc_real(size_t n);
 	template<typename T> static T (*alloc_complex(size_t n))[2]; // returns pointer to array of size 2
 
@@ -154,6 +172,11 @@ public:
 		}
 	}
 private:
+	FFTW(const FFTW&) = delete;
+	FFTW& operator=(const FFTW&) = delete;
+
+	bool ownsLock_;
+
 	static std::mutex mutex_;
 };
 
@@ -0,0 +1,88 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "FFTWPlanner.h"
+
+#include <algorithm> /* sort, unique */
+#include <chrono>
+#include <iostream>
+#include <utility> /* move */
+
+#include "FFTW.h"
+#include "Log.h"
+
+
+
+namespace GS {
+
+FFTWPlanner::FFTWPlanner(std::vector<unsigned int> sizeList, unsigned int flags)
+		: sizeList_{std::move(sizeList)}
+		, flags_{flags}
+		, ready_{}
+		, stop_{}
+{
+	std::sort(sizeList_.begin(), sizeList_.end());
+	sizeList_.erase(std::unique(sizeList_.begin(), sizeList_.end()), sizeList_.end());
+
+	thread_ = std::thread(&FFTWPlanner::run, this);
+}
+
+FFTWPlanner::~FFTWPlanner()
+{
+	stop_ = true;
+	thread_.join();
+}
+
+void
+FFTWPlanner::run()
+{
+	try {
+		const auto t0 = std::chrono::steady_clock::now();
+		for (unsigned int n : sizeList_) {
+			if (n != sizeList_.front()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(PLAN_PAUSE_MS));
+			}
+			if (stop_) return;
+
+			float* in = FFTW::alloc_real<float>(n);
+			fftwf_complex* out = FFTW::alloc_complex<float>(n / 2 + 1);
+			try {
+				FFTW fftw;
+				fftw.set_timelimit(PLAN_TIME_LIMIT_MS * 1.0e-3);
+				FFTWPlan plan = fftw.plan_dft_r2c_1d(n, in, out, flags_);
+				fftw.destroy_plan(plan);
+			} catch (...) {
+				FFTW::free(out);
+				FFTW::free(in);
+				throw;
+			}
+			FFTW::free(out);
+			FFTW::free(in);
+		}
+		if (Log::debugEnabled) {
+			const auto t1 = std::chrono::steady_clock::now();
+			std::cout << "FFTW plans ready in "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms." << std::endl;
+		}
+		ready_ = true;
+	} catch (std::exception& exc) {
+		std::cerr << "[FFTWPlanner::run] Caught exception: " << exc.what() << '.' << std::endl;
+	}
+}
+
+} /* namespace GS */
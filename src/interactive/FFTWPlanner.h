@@ -0,0 +1,71 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef FFTW_PLANNER_H
+#define FFTW_PLANNER_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+
+namespace GS {
+
+// Creates FFTW plans for a list of real DFT sizes in a background thread,
+// to accumulate wisdom. The plans are destroyed, but the wisdom remains, and
+// SignalDFT::upgradePlan() can then create the same plans without measuring.
+//
+// If the wisdom was imported from a file, the planning is fast.
+// Each plan is created with the FFTW mutex locked, with a short time limit,
+// and the thread pauses between plans so that other threads can create
+// their plans.
+class FFTWPlanner {
+public:
+	// flags: FFTW_MEASURE or FFTW_PATIENT.
+	// The sizes are planned in increasing order.
+	// The thread starts in the constructor.
+	FFTWPlanner(std::vector<unsigned int> sizeList, unsigned int flags);
+	// Waits for the end of the current plan.
+	~FFTWPlanner();
+
+	const std::vector<unsigned int>& sizeList() const { return sizeList_; }
+	unsigned int flags() const { return flags_; }
+	// Returns true when the wisdom for all the sizes is ready.
+	bool ready() const { return ready_; }
+private:
+	enum {
+		PLAN_TIME_LIMIT_MS = 100, // per plan
+		PLAN_PAUSE_MS = 50
+	};
+
+	FFTWPlanner(const FFTWPlanner&) = delete;
+	FFTWPlanner& operator=(const FFTWPlanner&) = delete;
+
+	void run();
+
+	std::vector<unsigned int> sizeList_;
+	const unsigned int flags_;
+	std::atomic<bool> ready_;
+	std::atomic<bool> stop_;
+	std::thread thread_;
+};
+
+} /* namespace GS */
+
+#endif // FFTW_PLANNER_H
@@ -21,17 +21,26 @@
 
 #include "InteractiveAudio.h"
 
+#include <algorithm> /* find, min */
 #include <cassert>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <thread>
+#include <utility> /* move */
+
+#include <jack/midiport.h>
 
 #include "Exception.h"
 #include "Log.h"
 #include "InteractiveVTMConfiguration.h"
-#include "VocalTractModelParameterValue.h"
+#include "RealtimeLog.h"
 #include "VTMUtil.h"
 
 #define PARAMETER_FILTER_PERIOD_SEC (50.0e-3)
+#define VTM_CHANGE_CROSSFADE_TIME_SEC (10.0e-3)
+#define VTM_BUILDER_POLL_INTERVAL_MS 5
+#define GOVERNOR_RAISE_LOAD_RATIO (0.6)
 
 
 
@@ -46,17 +55,15 @@ extern "C" {
 /*******************************************************************************
  * The process callback for this JACK application is called in a
  * special realtime thread once for each audio cycle.
+ *
+ * The processor does not throw exceptions. The vocal tract models are
+ * validated before they are passed to the processor.
  */
 int
 interactive_jack_process_callback(jack_nframes_t nframes, void* arg)
 {
-	try {
-		InteractiveAudio::Processor* p = static_cast<InteractiveAudio::Processor*>(arg);
-		return p->process(nframes);
-	} catch (std::exception& exc) {
-		std::cerr << "[Audio/jack_process_callback] Caught exception: " << exc.what() << '.' << std::endl;
-		return 1;
-	}
+	InteractiveAudio::Processor* p = static_cast<InteractiveAudio::Processor*>(arg);
+	return p->process(nframes);
 }
 
 /*******************************************************************************
@@ -66,7 +73,7 @@ interactive_jack_process_callback(jack_nframes_t nframes, void* arg)
 void
 interactive_jack_shutdown_callback(void* /*arg*/)
 {
-	if (Log::debugEnabled) std::cout << "[Audio] jack_shutdown_callback()" << std::endl;
+	RealtimeLog::post(RealtimeLog::LEVEL_DEBUG, "Audio", "jack_shutdown_callback()");
 }
 
 } /* extern "C" */
@@ -82,12 +89,24 @@ namespace GS {
  */
 InteractiveAudio::Processor::Processor(std::size_t numberOfParameters)
 		: outputPort_{}
+		, midiInputPort_{}
+		, midiControlMap_{}
 		, vtmBufferPos_{}
-		, maxAbsSampleValue_{}
 		, vocalTractModel_{}
-		, parameterRingbuffer_{}
-		, analysisRingbuffer_{}
+		, parameterTable_{}
+		, analysisQueue_{}
 		, paramValues_(numberOfParameters, 0.0)
+		, filteredParamValues_(numberOfParameters, 0.0)
+		, timelineTime_{}
+		, voiceRenderer_{numberOfParameters}
+		, pendingVTMChange_{}
+		, retiredVTMChange_{}
+		, fadingVTMBufferPos_{}
+		, crossfadePos_{}
+		, crossfadeLength_{}
+		, crossfadeBuffer_(CROSSFADE_BUFFER_SIZE)
+		, busyTime_{}
+		, processedFrames_{}
 {
 }
 
@@ -96,41 +115,160 @@ InteractiveAudio::Processor::Processor(std::size_t numberOfParameters)
  */
 InteractiveAudio::Processor::~Processor()
 {
+	delete pendingVTMChange_.exchange(nullptr);
+	delete retiredVTMChange_.exchange(nullptr);
 }
 
 /*******************************************************************************
  *
  */
 void
-InteractiveAudio::Processor::reset(jack_port_t* outputPort, InteractiveVTMConfiguration& configuration,
-			JackRingbuffer& parameterRingbuffer, JackRingbuffer& analysisRingbuffer)
+InteractiveAudio::Processor::reset(jack_port_t* outputPort, std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList,
+			SharedParameterTable& parameterTable, AnalysisQueue& analysisQueue,
+			const Settings& settings)
 {
+	if (vocalTractModelList.empty() || !vocalTractModelList[0]) {
+		THROW_EXCEPTION(MissingValueException, "Missing vocal tract model.");
+	}
+	for (auto& vtm : vocalTractModelList) {
+		if (!vtm) {
+			THROW_EXCEPTION(MissingValueException, "Missing vocal tract model.");
+		}
+		validateVocalTractModel(*vtm);
+	}
+	if (settings.timeline && settings.timeline->numberOfParameters() != paramValues_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid number of parameters in the timeline: "
+				<< settings.timeline->numberOfParameters() << '.');
+	}
+
+	releaseVocalTractModels();
+
 	outputPort_ = outputPort;
+	midiInputPort_ = settings.midiControlMap ? settings.midiInputPort : nullptr;
+	midiControlMap_ = settings.midiControlMap;
 	vtmBufferPos_ = 0;
-	maxAbsSampleValue_ = 0.0;
-	vocalTractModel_ = VTM::VocalTractModel::getInstance(*configuration.vtmData, true);
-	parameterRingbuffer_ = &parameterRingbuffer;
-	analysisRingbuffer_ = &analysisRingbuffer;
-	for (auto& v : paramValues_) {
-		v = 0.0;
+	outputLimiter_.reset(vocalTractModelList[0]->outputSampleRate(),
+				settings.limiterAttackTime, settings.limiterReleaseTime, settings.limiterMinLevel);
+	if (parameterTable.numberOfParameters() != paramValues_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid number of parameters in the table: "
+				<< parameterTable.numberOfParameters() << '.');
+	}
+	parameterTable_ = &parameterTable;
+	analysisQueue_ = &analysisQueue;
+	parameterTable_->readAll(paramValues_.data());
+	timelinePlayer_.reset(settings.timeline);
+	timelineTime_ = 0.0;
+	crossfadePos_ = 0;
+	crossfadeLength_ = static_cast<std::size_t>(vocalTractModelList[0]->outputSampleRate() * VTM_CHANGE_CROSSFADE_TIME_SEC);
+
+	if (vocalTractModelList.size() == 1) {
+		vocalTractModel_ = std::move(vocalTractModelList[0]);
+		paramFilter_.reset(paramValues_.size(), vocalTractModel_->internalSampleRate(), PARAMETER_FILTER_PERIOD_SEC);
+	} else {
+		voiceRenderer_.start(std::move(vocalTractModelList), settings.voiceLookaheadSamples,
+					settings.numRenderThreads, PARAMETER_FILTER_PERIOD_SEC, settings.timeline);
 	}
+}
 
-	paramFilters_.clear();
-	for (std::size_t i = 0; i < paramValues_.size(); ++i) {
-		paramFilters_.emplace_back(vocalTractModel_->internalSampleRate(), PARAMETER_FILTER_PERIOD_SEC);
+/*******************************************************************************
+ *
+ */
+std::vector<std::unique_ptr<VTM::VocalTractModel>>
+InteractiveAudio::Processor::releaseVocalTractModels()
+{
+	std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList = voiceRenderer_.stop();
+
+	// Complete the pending change.
+	std::unique_ptr<VocalTractModelChange> pendingChange{pendingVTMChange_.exchange(nullptr)};
+	if (pendingChange) {
+		vocalTractModel_ = std::move(pendingChange->vocalTractModel);
+	}
+	fadingVTMChange_.reset();
+	takeRetiredVocalTractModel();
+
+	if (vocalTractModel_) {
+		vocalTractModelList.push_back(std::move(vocalTractModel_));
+	}
+	return vocalTractModelList;
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+InteractiveAudio::Processor::requestVocalTractModelChange(std::unique_ptr<VTM::VocalTractModel>& vocalTractModel)
+{
+	if (!vocalTractModel) {
+		THROW_EXCEPTION(MissingValueException, "Missing vocal tract model.");
+	}
+	if (pendingVTMChange_.load(std::memory_order_acquire) ||
+			retiredVTMChange_.load(std::memory_order_acquire)) {
+		return false;
 	}
+	validateVocalTractModel(*vocalTractModel);
+
+	// The filter length depends on the internal sample rate, that may be
+	// different in the new model.
+	auto change = std::make_unique<VocalTractModelChange>();
+	change->paramFilter.reset(paramValues_.size(), vocalTractModel->internalSampleRate(), PARAMETER_FILTER_PERIOD_SEC);
+	change->vocalTractModel = std::move(vocalTractModel);
+	pendingVTMChange_.store(change.release(), std::memory_order_release);
+	return true;
+}
+
+/*******************************************************************************
+ * Throws an exception if the model does not accept the parameters.
+ *
+ * setAllParameters() throws only if the number of parameters is wrong,
+ * and the parameter values are checked against their ranges when they
+ * are loaded or mapped. So after this call the JACK thread can use
+ * the model without exceptions.
+ */
+void
+InteractiveAudio::Processor::validateVocalTractModel(VTM::VocalTractModel& vocalTractModel) const
+{
+	std::vector<float> values(paramValues_.size());
+	vocalTractModel.setAllParameters(values);
 }
 
 /*******************************************************************************
  *
  */
-float
-InteractiveAudio::Processor::calcScale(const std::vector<float>& buffer) {
-	const float maxValue = VTM::Util::maximumAbsoluteValue(buffer);
-	if (maxValue > maxAbsSampleValue_) {
-		maxAbsSampleValue_ = maxValue;
+std::unique_ptr<VTM::VocalTractModel>
+InteractiveAudio::Processor::takeRetiredVocalTractModel()
+{
+	std::unique_ptr<VocalTractModelChange> change{retiredVTMChange_.exchange(nullptr, std::memory_order_acquire)};
+	if (!change) return nullptr;
+	return std::move(change->vocalTractModel);
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+InteractiveAudio::Processor::getMIDIEvent(void* midiBuffer, std::uint32_t index, jack_nframes_t& time, std::size_t& parameter, float& value)
+{
+	jack_midi_event_t event;
+	if (jack_midi_event_get(&event, midiBuffer, index) != 0) {
+		return false;
+	}
+	if (!midiControlMap_->convert(event.buffer, event.size, parameter, value)) {
+		return false;
+	}
+	if (parameter >= paramValues_.size()) {
+		return false;
 	}
-	return VTM::Util::calculateOutputScale(maxAbsSampleValue_);
+	time = event.time;
+	return true;
+}
+
+/*******************************************************************************
+ * Reads the parameters that have changed since the last call.
+ */
+void
+InteractiveAudio::Processor::readParameters()
+{
+	parameterTable_->readChanged(paramValues_.data());
 }
 
 /*******************************************************************************
@@ -139,80 +277,183 @@ InteractiveAudio::Processor::calcScale(const std::vector<float>& buffer) {
 int
 InteractiveAudio::Processor::process(jack_nframes_t nframes)
 {
-	if (!vocalTractModel_) {
-		return 1; // end
-	}
+	const auto t0 = std::chrono::steady_clock::now();
 
-	jack_default_audio_sample_t* out = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(outputPort_, nframes));
-	const std::size_t sampleSize = sizeof(jack_default_audio_sample_t);
+	const int status = processBlock(nframes);
 
-	std::vector<float>& vtmOutputBuffer = vocalTractModel_->outputBuffer();
+	const auto t1 = std::chrono::steady_clock::now();
+	busyTime_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count(), std::memory_order_relaxed);
+	processedFrames_.fetch_add(nframes, std::memory_order_relaxed);
+	return status;
+}
 
-	const std::size_t n = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out,
-							nframes, calcScale(vtmOutputBuffer));
+/*******************************************************************************
+ *
+ */
+int
+InteractiveAudio::Processor::processBlock(jack_nframes_t nframes)
+{
+	if (voiceRenderer_.numberOfVoices() > 0) {
+		jack_default_audio_sample_t* out = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(outputPort_, nframes));
+
+		readParameters();
+		if (midiInputPort_) {
+			void* midiBuffer = jack_port_get_buffer(midiInputPort_, nframes);
+			const std::uint32_t numEvents = jack_midi_get_event_count(midiBuffer);
+			for (std::uint32_t i = 0; i < numEvents; ++i) {
+				jack_nframes_t time;
+				std::size_t parameter;
+				float value;
+				if (getMIDIEvent(midiBuffer, i, time, parameter, value)) {
+					paramValues_[parameter] = value;
+				}
+			}
+		}
+		voiceRenderer_.setParameters(paramValues_);
+		voiceRenderer_.mix(out, nframes);
 
-	// Send data to analysis.
-	for (std::size_t i = 0; i < n; ++i) {
-		if (analysisRingbuffer_ && analysisRingbuffer_->writeSpace() >= sampleSize) {
-#ifndef NDEBUG
-			const std::size_t bytesWritten =
-#endif
-			analysisRingbuffer_->write(reinterpret_cast<const char*>(out + i), sampleSize);
-			assert(bytesWritten == sampleSize);
-		} else {
-			//std::cerr << "[Audio::Processor::process] Analysis buffer full." << std::endl;
-			break;
+		outputLimiter_.process(out, nframes);
+		if (analysisQueue_) {
+			analysisQueue_->pushOverwrite(out, nframes);
 		}
+		return 0;
 	}
 
-	if (n == nframes) return 0; // JACK does not need more samples
+	if (!vocalTractModel_) {
+		RealtimeLog::post(RealtimeLog::LEVEL_ERROR, "Audio/process", "Missing vocal tract model.");
+		return 1; // end
+	}
 
-	// JACK needs more samples.
+	jack_default_audio_sample_t* out = static_cast<jack_default_audio_sample_t*>(jack_port_get_buffer(outputPort_, nframes));
 
-	// Read parameters from ringbuffer, and send them to vocal tract model.
-	const size_t elementSize = sizeof(VocalTractModelParameterValue);
-	VocalTractModelParameterValue pv;
-	const int numParam = paramValues_.size();
-	while (parameterRingbuffer_->readSpace() >= elementSize) {
-#ifndef NDEBUG
-		size_t bytesRead =
-#endif
-		parameterRingbuffer_->read(reinterpret_cast<char*>(&pv), elementSize);
-		assert(bytesRead == elementSize);
-		if (pv.index >= 0 && pv.index < numParam) {
-			paramValues_[pv.index] = pv.value;
+	if (!fadingVTMChange_) {
+		VocalTractModelChange* change = pendingVTMChange_.exchange(nullptr, std::memory_order_acquire);
+		if (change) {
+			// After the swaps, the change contains the old model and filter.
+			change->vocalTractModel.swap(vocalTractModel_);
+			paramFilter_.swap(change->paramFilter);
+			paramFilter_.fill(filteredParamValues_.data());
+			fadingVTMChange_.reset(change);
+			fadingVTMBufferPos_ = vtmBufferPos_;
+			vtmBufferPos_ = 0;
+			crossfadePos_ = 0;
 		}
 	}
 
-	const std::size_t targetBufferSize = nframes - n;
-	while (vtmOutputBuffer.size() < targetBufferSize) {
-		for (int i = 0; i < numParam; ++i) {
-			// May throw exception.
-			vocalTractModel_->setParameter(i, paramFilters_[i].filter(paramValues_[i]));
+	// Read the parameters from the table once per block, before the MIDI
+	// events, so that the MIDI values are not overwritten in this block.
+	readParameters();
+
+	jack_nframes_t pos = 0;
+	if (midiInputPort_) {
+		// The parameter values are changed at the frame offsets of the events.
+		void* midiBuffer = jack_port_get_buffer(midiInputPort_, nframes);
+		const std::uint32_t numEvents = jack_midi_get_event_count(midiBuffer);
+		for (std::uint32_t i = 0; i < numEvents; ++i) {
+			jack_nframes_t time;
+			std::size_t parameter;
+			float value;
+			if (!getMIDIEvent(midiBuffer, i, time, parameter, value)) continue;
+			time = std::min(time, nframes);
+			if (time > pos) {
+				render(out + pos, time - pos);
+				pos = time;
+			}
+			paramValues_[parameter] = value;
 		}
-		vocalTractModel_->execSynthesisStep();
+	}
+	if (pos < nframes) {
+		render(out + pos, nframes - pos);
+	}
+	if (fadingVTMChange_) {
+		crossfade(out, nframes);
 	}
 
-	const std::size_t n2 = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out + n,
-							nframes - n, calcScale(vtmOutputBuffer));
-	assert(n2 == nframes - n);
+	// Only the new samples are analyzed.
+	outputLimiter_.process(out, nframes);
+
+	// Send data to analysis. If the queue is full, the oldest samples are overwritten.
+	if (analysisQueue_) {
+		analysisQueue_->pushOverwrite(out, nframes);
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Renders samples using the current vocal tract model.
+ */
+void
+InteractiveAudio::Processor::render(float* out, std::size_t n)
+{
+	std::vector<float>& vtmOutputBuffer = vocalTractModel_->outputBuffer();
+
+	const std::size_t n1 = VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out, n, 1.0f);
+	if (n1 < n) {
+		// JACK needs more samples.
+		const std::size_t targetBufferSize = n - n1;
+		const double timelineStepTime = 1.0 / vocalTractModel_->internalSampleRate();
+		while (vtmOutputBuffer.size() < targetBufferSize) {
+			paramFilter_.filter(paramValues_.data(), filteredParamValues_.data());
+			if (timelinePlayer_.active()) {
+				timelinePlayer_.getValues(timelineTime_, filteredParamValues_.data());
+				timelineTime_ += timelineStepTime;
+			}
+			vocalTractModel_->setAllParameters(filteredParamValues_); // validated
+			vocalTractModel_->execSynthesisStep();
+		}
 
-	// Send data to analysis.
-	jack_default_audio_sample_t* out2 = out + n;
-	for (std::size_t i = 0; i < n2; ++i) {
-		if (analysisRingbuffer_ && analysisRingbuffer_->writeSpace() >= sampleSize) {
 #ifndef NDEBUG
-			const std::size_t bytesWritten =
+		const std::size_t n2 =
 #endif
-			analysisRingbuffer_->write(reinterpret_cast<const char*>(out2 + i), sampleSize);
-			assert(bytesWritten == sampleSize);
-		} else {
-			//std::cerr << "[Audio::Processor::process] Analysis buffer full (2)." << std::endl;
-			break;
+		VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos_, out + n1, n - n1, 1.0f);
+		assert(n2 == n - n1);
+	}
+}
+
+/*******************************************************************************
+ * Mixes the output of the old vocal tract model, fading out.
+ *
+ * The old model uses the last filtered parameter values.
+ * At the end of the crossfade, the old model is passed to another thread,
+ * that will destroy it.
+ */
+void
+InteractiveAudio::Processor::crossfade(float* out, std::size_t n)
+{
+	if (crossfadePos_ < crossfadeLength_) {
+		VTM::VocalTractModel& vtm = *fadingVTMChange_->vocalTractModel;
+		std::vector<float>& vtmOutputBuffer = vtm.outputBuffer();
+		vtm.setAllParameters(filteredParamValues_);
+
+		const float gainStep = 1.0f / crossfadeLength_;
+		std::size_t pos = 0;
+		while (pos < n && crossfadePos_ < crossfadeLength_) {
+			const std::size_t blockSize = std::min(std::min(n - pos, crossfadeLength_ - crossfadePos_), crossfadeBuffer_.size());
+			std::size_t blockPos = 0;
+			while (blockPos < blockSize) {
+				if (vtmOutputBuffer.empty()) {
+					vtm.execSynthesisStep();
+					continue;
+				}
+				blockPos += VTM::Util::getSamples(vtmOutputBuffer, fadingVTMBufferPos_, crossfadeBuffer_.data() + blockPos,
+									blockSize - blockPos, 1.0f);
+			}
+			for (std::size_t i = 0; i < blockSize; ++i, ++crossfadePos_) {
+				const float gain = crossfadePos_ * gainStep; // of the new model
+				out[pos + i] = gain * out[pos + i] + (1.0f - gain) * crossfadeBuffer_[i];
+			}
+			pos += blockSize;
 		}
 	}
 
-	return 0;
+	if (crossfadePos_ >= crossfadeLength_) {
+		// If the previous retired model has not been taken, try again in the next cycle.
+		VocalTractModelChange* expected = nullptr;
+		if (retiredVTMChange_.compare_exchange_strong(expected, fadingVTMChange_.get(), std::memory_order_release)) {
+			fadingVTMChange_.release();
+		}
+	}
 }
 
 /*******************************************************************************
@@ -221,21 +462,40 @@ InteractiveAudio::Processor::process(jack_nframes_t nframes)
 InteractiveAudio::InteractiveAudio(InteractiveVTMConfiguration& configuration)
 		: state_{State::stopped}
 		, configuration_{configuration}
+		, vtmPool_{true, MAX_POOL_CONFIGURATIONS, MAX_POOL_INSTANCES_PER_CONFIGURATION}
 		, processor_{configuration_.dynamicParamList.size()}
-		, parameterRingbuffer_{std::make_unique<JackRingbuffer>(PARAMETER_RINGBUFFER_SIZE * sizeof(VocalTractModelParameterValue))}
-		// +1 because the ringbuffer keeps at least one position open.
-		, analysisRingbuffer_{std::make_unique<JackRingbuffer>(MAX_NUM_SAMPLES_FOR_ANALYSIS * sizeof(jack_default_audio_sample_t) + 1)}
+		, parameterTable_{std::make_unique<SharedParameterTable>(configuration_.dynamicParamList.size())}
+		, analysisQueue_{std::make_unique<AnalysisQueue>(ANALYSIS_QUEUE_SIZE)}
 		, jackClient_{}
 		, sampleRate_{}
+		, timeline_{}
+		, activeTimeline_{}
+		, stopVTMBuilder_{}
+		, vtmBuilderStatus_{VTMBuilderStatus::idle}
+		, vtmBuild_{}
+		, vtmChangeRequested_{}
+		, stopVTMPreparation_{}
+		, qualityLevel_{}
+		, governorBusyTime_{}
+		, governorProcessedFrames_{}
+		, governorLowLoadCount_{}
 {
 }
 
+/*******************************************************************************
+ * Destructor.
+ */
+InteractiveAudio::~InteractiveAudio()
+{
+	stopVTMBuilder();
+	stopVTMPreparation();
+}
+
 /*******************************************************************************
  * Starts the connection to the JACK server.
  *
  * Preconditions:
- * - The parameter ringbuffer must be filled with a complete set of parameter
- *   values.
+ * - The parameter table must contain the current parameter values.
  */
 void
 InteractiveAudio::start()
@@ -252,6 +512,16 @@ InteractiveAudio::start()
 
 	jack_port_t* outputPort = newJackClient->registerPort("output", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
 
+	jack_port_t* midiInputPort = nullptr;
+	midiControlMap_.reset();
+	if (!configuration_.midiMappingFilePath.empty()) {
+		midiControlMap_ = std::make_unique<MIDIControlMap>(configuration_.midiMappingFilePath,
+								configuration_.dynamicParamNameList,
+								configuration_.dynamicParamMinList,
+								configuration_.dynamicParamMaxList);
+		midiInputPort = newJackClient->registerPort("midi_input", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+	}
+
 	jack_nframes_t jackSampleRate = newJackClient->getSampleRate();
 	sampleRate_ = jackSampleRate;
 
@@ -261,7 +531,41 @@ InteractiveAudio::start()
 	if (Log::debugEnabled) std::cout << "Output sample rate: " << outputRate << std::endl;
 
 	// Prepare the audio processor.
-	processor_.reset(outputPort, configuration_, *parameterRingbuffer_, *analysisRingbuffer_);
+	const auto t0 = std::chrono::steady_clock::now();
+	if (qualityLevel_ >= configuration_.numQualityLevels) {
+		qualityLevel_ = 0;
+	}
+	std::vector<std::unique_ptr<VTM::VocalTractModel>> vtmList;
+	vtmKeyList_.clear();
+	staticParamList_.resize(configuration_.staticParamNameList.size());
+	for (std::size_t i = 0; i < staticParamList_.size(); ++i) {
+		staticParamList_[i] = configuration_.staticParameter(i);
+	}
+	for (unsigned int i = 0; i < configuration_.numVoices; ++i) {
+		vtmKeyList_.push_back(configuration_.voiceVTMDataKey(i, qualityLevel_));
+		vtmList.push_back(vtmPool_.acquire(vtmKeyList_.back(), *configuration_.voiceVTMData(i, qualityLevel_)));
+	}
+	Processor::Settings settings;
+	settings.limiterAttackTime = configuration_.outputLimiterAttackTime * 1.0e-3f;
+	settings.limiterReleaseTime = configuration_.outputLimiterReleaseTime * 1.0e-3f;
+	settings.limiterMinLevel = configuration_.outputLimiterMinLevel;
+	settings.voiceLookaheadSamples = VOICE_LOOKAHEAD_PERIODS * newJackClient->getBufferSize();
+	const unsigned int numCores = std::thread::hardware_concurrency();
+	settings.numRenderThreads = (numCores > 1) ? numCores - 1 : 1; // leave one core for the JACK thread
+	settings.timeline = timeline_;
+	settings.midiInputPort = midiInputPort;
+	settings.midiControlMap = midiControlMap_.get();
+	processor_.reset(outputPort, std::move(vtmList), *parameterTable_, *analysisQueue_, settings);
+	if (Log::debugEnabled) {
+		const auto t1 = std::chrono::steady_clock::now();
+		std::cout << "Vocal tract models ready in "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us ("
+			<< configuration_.numVoices << " voice(s))." << std::endl;
+	}
+
+	governorBusyTime_ = processor_.busyTime();
+	governorProcessedFrames_ = processor_.processedFrames();
+	governorLowLoadCount_ = 0;
 
 	newJackClient->activate();
 
@@ -278,11 +582,27 @@ InteractiveAudio::start()
 	for (size_t i = 0; i < 2 && ports.list[i]; ++i) {
 		newJackClient->connect(JackClient::portName(outputPort), ports.list[i]);
 	}
+	if (midiInputPort) {
+		// Connect all the physical MIDI inputs.
+		JackPorts midiPorts;
+		newJackClient->getPorts(NULL, JACK_DEFAULT_MIDI_TYPE, JackPortIsPhysical | JackPortIsOutput, midiPorts);
+		for (size_t i = 0; midiPorts.list && midiPorts.list[i]; ++i) {
+			try {
+				newJackClient->connect(midiPorts.list[i], JackClient::portName(midiInputPort));
+			} catch (std::exception& exc) {
+				std::cerr << "Could not connect the MIDI port " << midiPorts.list[i] << ": " << exc.what() << std::endl;
+			}
+		}
+	}
 
 	jackClient_.reset();
 	jackClient_ = std::move(newJackClient);
+	activeTimeline_ = timeline_;
 	state_ = State::started;
 	if (Log::debugEnabled) std::cout << "Audio started." << std::endl;
+
+	// The output rate may have changed.
+	prepareVocalTractModels();
 }
 
 /*******************************************************************************
@@ -293,11 +613,317 @@ InteractiveAudio::stop()
 {
 	if (state_ == State::stopped) return;
 
+	stopVTMBuilder();
+	// The processor completes the change if the new model has been sent.
+	const VTMBuilderStatus builderStatus = vtmBuilderStatus_.load(std::memory_order_acquire);
+	if (builderStatus == VTMBuilderStatus::sent || builderStatus == VTMBuilderStatus::finished) {
+		commitVTMBuild();
+	}
+	vtmBuilderStatus_ = VTMBuilderStatus::idle;
+	vtmChangeRequested_ = false;
+
 	jackClient_.reset();
+	activeTimeline_ = nullptr;
+
+	const VoiceRenderer& voiceRenderer = processor_.voiceRenderer();
+	if (Log::debugEnabled && voiceRenderer.numberOfVoices() > 0) {
+		for (std::size_t i = 0; i < voiceRenderer.numberOfVoices(); ++i) {
+			std::cout << "Voice " << i << " CPU load: " << voiceRenderer.voiceLoad(i) * 100.0 << '%' << std::endl;
+		}
+		std::cout << "Voice render underflows: " << voiceRenderer.underflowCount() << std::endl;
+	}
+
+	std::vector<std::unique_ptr<VTM::VocalTractModel>> vtmList = processor_.releaseVocalTractModels();
+	for (std::size_t i = 0; i < vtmList.size() && i < vtmKeyList_.size(); ++i) {
+		vtmPool_.release(vtmKeyList_[i], std::move(vtmList[i]));
+	}
 
 	state_ = State::stopped;
 	if (Log::debugEnabled) std::cout << "Audio stopped." << std::endl;
 	return;
 }
 
+/*******************************************************************************
+ *
+ */
+bool
+InteractiveAudio::updateStaticParameters()
+{
+	if (state_ != State::started || configuration_.numVoices != 1 || vtmKeyList_.size() != 1) {
+		return false;
+	}
+
+	if (vtmBuilderStatus_.load(std::memory_order_acquire) == VTMBuilderStatus::idle) {
+		startVTMBuilder(qualityLevel_);
+	} else {
+		vtmChangeRequested_ = true;
+	}
+	return true;
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+InteractiveAudio::updateVocalTractModel(std::string& errorMessage)
+{
+	bool ok = true;
+
+	// The builder thread has returned or is returning, so join() does not block.
+	const VTMBuilderStatus builderStatus = vtmBuilderStatus_.load(std::memory_order_acquire);
+	if (builderStatus == VTMBuilderStatus::finished) {
+		vtmBuilderThread_.join();
+		commitVTMBuild();
+		vtmBuilderStatus_ = VTMBuilderStatus::idle;
+	} else if (builderStatus == VTMBuilderStatus::failed) {
+		vtmBuilderThread_.join();
+		vtmBuilderStatus_ = VTMBuilderStatus::idle;
+		if (vtmBuild_.staticParamList != staticParamList_) {
+			// The running model keeps its key and static parameters.
+			for (std::size_t i = 0; i < staticParamList_.size(); ++i) {
+				configuration_.setStaticParameter(i, staticParamList_[i]);
+			}
+			vtmChangeRequested_ = false;
+			errorMessage = vtmBuilderError_;
+			ok = false;
+		} else {
+			std::cerr << "[InteractiveAudio::updateVocalTractModel] Could not change the vocal tract model: "
+				<< vtmBuilderError_ << '.' << std::endl;
+		}
+	}
+
+	if (vtmChangeRequested_ && state_ == State::started &&
+			vtmBuilderStatus_.load(std::memory_order_acquire) == VTMBuilderStatus::idle) {
+		vtmChangeRequested_ = false;
+		startVTMBuilder(qualityLevel_);
+	}
+	return ok;
+}
+
+/*******************************************************************************
+ *
+ */
+void
+InteractiveAudio::updateGovernor()
+{
+	if (state_ != State::started || configuration_.governorTargetLoad <= 0.0f) return;
+
+	const unsigned long long busyTime = processor_.busyTime();
+	const unsigned long long processedFrames = processor_.processedFrames();
+	const unsigned long long numFrames = processedFrames - governorProcessedFrames_;
+	if (numFrames < static_cast<unsigned long long>(sampleRate_) * GOVERNOR_MIN_MEASUREMENT_TIME_MS / 1000U) {
+		return;
+	}
+	const double load = (busyTime - governorBusyTime_) * 1.0e-9 / (static_cast<double>(numFrames) / sampleRate_);
+	governorBusyTime_ = busyTime;
+	governorProcessedFrames_ = processedFrames;
+
+	// The measurement includes the crossfade of the last change.
+	if (vtmBuilderStatus_.load(std::memory_order_acquire) != VTMBuilderStatus::idle || vtmChangeRequested_) return;
+	if (configuration_.numVoices != 1 || vtmKeyList_.size() != 1) return;
+
+	const float targetLoad = configuration_.governorTargetLoad;
+	unsigned int newQualityLevel = qualityLevel_;
+	if (load > targetLoad) {
+		governorLowLoadCount_ = 0;
+		if (qualityLevel_ + 1U < configuration_.numQualityLevels) {
+			newQualityLevel = qualityLevel_ + 1U;
+		} else if (Log::debugEnabled) {
+			std::cout << "[Governor] Load: " << load * 100.0 << "% (target: " << targetLoad * 100.0
+				<< "%). Already at the cheapest quality level (" << qualityLevel_ << ")." << std::endl;
+		}
+	} else if (qualityLevel_ > 0 && load < targetLoad * GOVERNOR_RAISE_LOAD_RATIO) {
+		if (++governorLowLoadCount_ >= GOVERNOR_RAISE_INTERVALS) {
+			newQualityLevel = qualityLevel_ - 1U;
+		}
+	} else {
+		governorLowLoadCount_ = 0;
+	}
+	if (newQualityLevel == qualityLevel_) return;
+
+	if (Log::debugEnabled) {
+		std::cout << "[Governor] Load: " << load * 100.0 << "% (target: " << targetLoad * 100.0
+			<< "%). Changing quality level: " << qualityLevel_ << " -> " << newQualityLevel << '.' << std::endl;
+	}
+	governorLowLoadCount_ = 0;
+	// qualityLevel_ is updated when the new model is used by the processor.
+	startVTMBuilder(newQualityLevel);
+}
+
+/*******************************************************************************
+ * Creates a vocal tract model for the voice 0 in the builder thread,
+ * using the current configuration.
+ *
+ * vtmKeyList_ and qualityLevel_ are updated only when the change is completed.
+ */
+void
+InteractiveAudio::startVTMBuilder(unsigned int qualityLevel)
+{
+	assert(!vtmBuilderThread_.joinable());
+
+	std::unique_ptr<ConfigurationData> vtmData = configuration_.voiceVTMData(0, qualityLevel);
+	vtmBuild_.key = configuration_.voiceVTMDataKey(0, qualityLevel);
+	vtmBuild_.qualityLevel = qualityLevel;
+	vtmBuild_.staticParamList.resize(staticParamList_.size());
+	for (std::size_t i = 0; i < staticParamList_.size(); ++i) {
+		vtmBuild_.staticParamList[i] = configuration_.staticParameter(i);
+	}
+
+	stopVTMBuilder_ = false;
+	vtmBuilderStatus_ = VTMBuilderStatus::running;
+	vtmBuilderThread_ = std::thread(&InteractiveAudio::buildVocalTractModel, this,
+					vtmKeyList_[0], vtmBuild_.key, std::move(vtmData));
+}
+
+/*******************************************************************************
+ * The new model is used by the processor.
+ */
+void
+InteractiveAudio::commitVTMBuild()
+{
+	vtmKeyList_[0] = vtmBuild_.key;
+	qualityLevel_ = vtmBuild_.qualityLevel;
+	staticParamList_ = vtmBuild_.staticParamList;
+}
+
+/*******************************************************************************
+ * Builder thread.
+ *
+ * Takes the vocal tract model from the pool, sends it to the processor, then
+ * waits for the end of the crossfade and returns the old model to the pool.
+ *
+ * The result is reported in vtmBuilderStatus_.
+ */
+void
+InteractiveAudio::buildVocalTractModel(std::string oldKey, std::string newKey, std::unique_ptr<ConfigurationData> vtmData)
+{
+	try {
+		const auto t0 = std::chrono::steady_clock::now();
+		std::unique_ptr<VTM::VocalTractModel> vtm = vtmPool_.acquire(newKey, *vtmData);
+		if (Log::debugEnabled) {
+			const auto t1 = std::chrono::steady_clock::now();
+			std::cout << "New vocal tract model ready in "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us." << std::endl;
+		}
+
+		bool sent = false;
+		while (!stopVTMBuilder_) {
+			if (processor_.requestVocalTractModelChange(vtm)) {
+				sent = true;
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(VTM_BUILDER_POLL_INTERVAL_MS));
+		}
+		if (!sent) {
+			// Stopped.
+			vtmPool_.release(newKey, std::move(vtm));
+			return;
+		}
+		vtmBuilderStatus_.store(VTMBuilderStatus::sent, std::memory_order_release);
+
+		while (!stopVTMBuilder_) {
+			std::unique_ptr<VTM::VocalTractModel> oldVTM = processor_.takeRetiredVocalTractModel();
+			if (oldVTM) {
+				vtmPool_.release(oldKey, std::move(oldVTM));
+				if (Log::debugEnabled) std::cout << "Vocal tract model changed." << std::endl;
+				vtmBuilderStatus_.store(VTMBuilderStatus::finished, std::memory_order_release);
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(VTM_BUILDER_POLL_INTERVAL_MS));
+		}
+	} catch (std::exception& exc) {
+		vtmBuilderError_ = exc.what();
+		vtmBuilderStatus_.store(VTMBuilderStatus::failed, std::memory_order_release);
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+InteractiveAudio::stopVTMBuilder()
+{
+	if (vtmBuilderThread_.joinable()) {
+		stopVTMBuilder_ = true;
+		vtmBuilderThread_.join();
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+InteractiveAudio::prepareVocalTractModels()
+{
+	stopVTMPreparation();
+
+	const unsigned int qualityLevel = (qualityLevel_ < configuration_.numQualityLevels) ? qualityLevel_ : 0;
+	std::vector<std::pair<std::string, std::unique_ptr<ConfigurationData>>> vtmDataList;
+	auto add = [&](unsigned int voice, unsigned int level) {
+		std::string key = configuration_.voiceVTMDataKey(voice, level);
+		// The instances used by the processor are not in the pool.
+		if (state_ == State::started && std::find(vtmKeyList_.begin(), vtmKeyList_.end(), key) != vtmKeyList_.end()) {
+			return;
+		}
+		vtmDataList.emplace_back(std::move(key), configuration_.voiceVTMData(voice, level));
+	};
+	for (unsigned int i = 0; i < configuration_.numVoices; ++i) {
+		add(i, qualityLevel);
+	}
+	if (configuration_.numVoices == 1 && configuration_.governorTargetLoad > 0.0f) {
+		for (unsigned int level = 0; level < configuration_.numQualityLevels; ++level) {
+			if (level != qualityLevel) add(0, level);
+		}
+	}
+	if (vtmDataList.empty()) return;
+
+	stopVTMPreparation_ = false;
+	vtmPreparationThread_ = std::thread(&InteractiveAudio::prepareVocalTractModelList, this, std::move(vtmDataList));
+}
+
+/*******************************************************************************
+ *
+ */
+void
+InteractiveAudio::clearVocalTractModels()
+{
+	stopVTMPreparation();
+	vtmPool_.clear();
+}
+
+/*******************************************************************************
+ * Preparation thread.
+ */
+void
+InteractiveAudio::prepareVocalTractModelList(std::vector<std::pair<std::string, std::unique_ptr<ConfigurationData>>> vtmDataList)
+{
+	try {
+		const auto t0 = std::chrono::steady_clock::now();
+		for (const auto& item : vtmDataList) {
+			if (stopVTMPreparation_) return;
+			vtmPool_.prepare(item.first, *item.second, 1);
+		}
+		if (Log::debugEnabled) {
+			const auto t1 = std::chrono::steady_clock::now();
+			std::cout << "Vocal tract models prepared in "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us ("
+				<< vtmDataList.size() << " configuration(s))." << std::endl;
+		}
+	} catch (std::exception& exc) {
+		std::cerr << "[InteractiveAudio::prepareVocalTractModelList] Caught exception: " << exc.what() << '.' << std::endl;
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+InteractiveAudio::stopVTMPreparation()
+{
+	if (vtmPreparationThread_.joinable()) {
+		stopVTMPreparation_ = true;
+		vtmPreparationThread_.join();
+	}
+}
+
 } /* namespace GS */
@@ -18,76 +18,255 @@
 #ifndef INTERACTIVE_AUDIO_H_
 #define INTERACTIVE_AUDIO_H_
 
+#include <atomic>
 #include <cstddef> /* std::size_t */
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <thread>
+#include <utility> /* pair */
 #include <vector>
 
+#include "InteractiveVTMConfiguration.h"
 #include "JackClient.h"
-#include "JackRingbuffer.h"
-#include "MovingAverageFilter.h"
+#include "MIDIControlMap.h"
+#include "MovingAverageFilterBank.h"
+#include "OutputLimiter.h"
+#include "ParameterTimeline.h"
+#include "SharedParameterTable.h"
+#include "SPSCQueue.h"
 #include "VocalTractModel.h"
+#include "VocalTractModelPool.h"
+#include "VoiceRenderer.h"
 
 
 
 namespace GS {
 
-struct InteractiveVTMConfiguration;
-
 class InteractiveAudio {
 public:
 	enum {
-		PARAMETER_RINGBUFFER_SIZE = 32,
-		MAX_NUM_SAMPLES_FOR_ANALYSIS = 65536
+		MAX_NUM_SAMPLES_FOR_ANALYSIS = 65536,
+		// The analysis queue is larger than the analysis block, so the
+		// producer rarely overwrites the samples being read.
+		ANALYSIS_QUEUE_SIZE = 2 * MAX_NUM_SAMPLES_FOR_ANALYSIS
 	};
 
+	typedef SPSCQueue<jack_default_audio_sample_t> AnalysisQueue;
+
 	class Processor {
 	public:
+		struct Settings {
+			float limiterAttackTime;  // seconds
+			float limiterReleaseTime; // seconds
+			float limiterMinLevel;
+			// Used only with more than one voice.
+			std::size_t voiceLookaheadSamples;
+			unsigned int numRenderThreads;
+			// The parameters that have points in the timeline are not
+			// filtered, and ignore the values from the parameter table.
+			// May be null.
+			const ParameterTimeline* timeline;
+			// The MIDI control messages are applied at their frame offsets
+			// (with more than one voice, at the start of the block).
+			// May be null.
+			jack_port_t* midiInputPort;
+			const MIDIControlMap* midiControlMap;
+		};
+
 		Processor(std::size_t numberOfParameters);
 		~Processor();
 
 		// Called only by the JACK thread.
 		int process(jack_nframes_t nframes);
 
-		// Can be called by the main thread only when the JACK thread is not running.
-		void reset(jack_port_t* outputPort, InteractiveVTMConfiguration& configuration,
-				JackRingbuffer& parameterRingbuffer, JackRingbuffer& analysisRingbuffer);
+		// These functions can be called by the main thread only when the JACK thread is not running.
+		// With more than one vocal tract model, the voices are rendered by worker threads.
+		// reset() throws an exception if a model does not accept the parameters.
+		void reset(jack_port_t* outputPort, std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList,
+				SharedParameterTable& parameterTable, AnalysisQueue& analysisQueue,
+				const Settings& settings);
+		std::vector<std::unique_ptr<VTM::VocalTractModel>> releaseVocalTractModels();
+		const VoiceRenderer& voiceRenderer() const { return voiceRenderer_; }
+
+		// Can be called by any thread.
+		// Total time spent in process() (ns), and number of frames processed.
+		unsigned long long busyTime() const { return busyTime_.load(std::memory_order_relaxed); }
+		unsigned long long processedFrames() const { return processedFrames_.load(std::memory_order_relaxed); }
+
+		// These functions can be called by one non-realtime thread while the JACK thread is running.
+		// Only with one vocal tract model.
+		// The JACK thread crossfades from the current model to the new one.
+		// Returns false if the previous change has not been completed. In this case
+		// vocalTractModel is not modified.
+		// Throws an exception if the model does not accept the parameters.
+		bool requestVocalTractModelChange(std::unique_ptr<VTM::VocalTractModel>& vocalTractModel);
+		// Returns the model that was replaced, after the end of the crossfade. May return null.
+		std::unique_ptr<VTM::VocalTractModel> takeRetiredVocalTractModel();
 	private:
-		float calcScale(const std::vector<float>& buffer);
+		enum {
+			CROSSFADE_BUFFER_SIZE = 256
+		};
+
+		// The parameter filter is built by the requesting thread, for the
+		// internal sample rate of the new model.
+		struct VocalTractModelChange {
+			std::unique_ptr<VTM::VocalTractModel> vocalTractModel;
+			MovingAverageFilterBank paramFilter;
+		};
+
+		// Called by non-realtime threads.
+		void validateVocalTractModel(VTM::VocalTractModel& vocalTractModel) const;
+		int processBlock(jack_nframes_t nframes);
+		// Returns false if the event is not mapped to a parameter.
+		bool getMIDIEvent(void* midiBuffer, std::uint32_t index, jack_nframes_t& time, std::size_t& parameter, float& value);
+		void readParameters();
+		void render(float* out, std::size_t n);
+		void crossfade(float* out, std::size_t n);
 
 		jack_port_t* outputPort_;
+		jack_port_t* midiInputPort_;
+		const MIDIControlMap* midiControlMap_;
 		std::size_t vtmBufferPos_;
-		float maxAbsSampleValue_;
+		OutputLimiter outputLimiter_;
 		std::unique_ptr<VTM::VocalTractModel> vocalTractModel_;
-		JackRingbuffer* parameterRingbuffer_;
-		JackRingbuffer* analysisRingbuffer_;
+		SharedParameterTable* parameterTable_;
+		AnalysisQueue* analysisQueue_;
 		std::vector<float> paramValues_;
-		std::vector<VTM::MovingAverageFilter<float>> paramFilters_;
+		std::vector<float> filteredParamValues_;
+		MovingAverageFilterBank paramFilter_;
+		ParameterTimeline::Player timelinePlayer_;
+		double timelineTime_;
+		VoiceRenderer voiceRenderer_;
+
+		// Vocal tract model change.
+		std::atomic<VocalTractModelChange*> pendingVTMChange_; // owned
+		std::atomic<VocalTractModelChange*> retiredVTMChange_; // owned
+		std::unique_ptr<VocalTractModelChange> fadingVTMChange_; // contains the old model and filter
+		std::size_t fadingVTMBufferPos_;
+		std::size_t crossfadePos_;
+		std::size_t crossfadeLength_;
+		std::vector<float> crossfadeBuffer_;
+
+		std::atomic<unsigned long long> busyTime_;
+		std::atomic<unsigned long long> processedFrames_;
 	};
 
 	InteractiveAudio(InteractiveVTMConfiguration& configuration);
+	~InteractiveAudio();
 
 	void start();
 	void stop();
 
-	JackRingbuffer& parameterRingbuffer() { return *parameterRingbuffer_; }
-	JackRingbuffer& analysisRingbuffer() { return *analysisRingbuffer_; }
+	// Creates the vocal tract models of the current configuration in a
+	// background thread, so that start() and the governor take them from
+	// the pool. With the governor, all the quality levels are prepared.
+	// Before the first start() the configured output rate is used.
+	void prepareVocalTractModels();
+	// Destroys the prepared vocal tract models. Must be called after
+	// the configuration files have been reloaded.
+	void clearVocalTractModels();
+
+	// Applies the current static parameters without restarting the audio.
+	// The new vocal tract model is created in a background thread, and the
+	// result is reported by updateVocalTractModel().
+	// Returns false if the audio must be restarted to apply the parameters
+	// (stopped audio or more than one voice).
+	bool updateStaticParameters();
+
+	// Must be called periodically by the main thread.
+	// Completes the vocal tract model changes, and starts the pending change.
+	// Returns false if the static parameters could not be applied. In this
+	// case the static parameters of the running model are restored in the
+	// configuration, and errorMessage contains the reason.
+	bool updateVocalTractModel(std::string& errorMessage);
+
+	// CPU load governor. Must be called periodically by the main thread.
+	// If the load of the JACK callback is above the target, changes
+	// to a cheaper quality level. If the load stays low, returns to
+	// a more expensive level. The changes use the same crossfade of
+	// updateStaticParameters().
+	// Only with one voice.
+	void updateGovernor();
+
+	// The timeline will be played from the beginning in the next start().
+	// The timeline must not be destroyed before the audio is stopped.
+	// Can be null.
+	void setTimeline(const ParameterTimeline* timeline) { timeline_ = timeline; }
+	// The timeline used by the running audio. Null if the audio is stopped
+	// or was started without a timeline.
+	const ParameterTimeline* activeTimeline() const { return activeTimeline_; }
+
+	// The dynamic parameters. Can be written by the main thread at any time.
+	SharedParameterTable& parameterTable() { return *parameterTable_; }
+	AnalysisQueue& analysisQueue() { return *analysisQueue_; }
 	unsigned int sampleRate() const { return sampleRate_; }
 private:
 	enum class State {
 		started,
 		stopped
 	};
+	enum {
+		MAX_POOL_CONFIGURATIONS = InteractiveVTMConfiguration::MAX_VOICES + InteractiveVTMConfiguration::MAX_QUALITY_LEVELS,
+		MAX_POOL_INSTANCES_PER_CONFIGURATION = 1,
+		VOICE_LOOKAHEAD_PERIODS = 2, // number of JACK periods rendered ahead
+		GOVERNOR_MIN_MEASUREMENT_TIME_MS = 250,
+		GOVERNOR_RAISE_INTERVALS = 8 // number of low load measurements before raising the quality
+	};
 
 	InteractiveAudio(const InteractiveAudio&) = delete;
 	InteractiveAudio& operator=(const InteractiveAudio&) = delete;
 
+	// Vocal tract model builder thread.
+	// startVTMBuilder() must be called only when the status is idle.
+	void startVTMBuilder(unsigned int qualityLevel);
+	void commitVTMBuild();
+	void buildVocalTractModel(std::string oldKey, std::string newKey, std::unique_ptr<ConfigurationData> vtmData);
+	void stopVTMBuilder();
+
+	// Vocal tract model preparation thread.
+	void prepareVocalTractModelList(std::vector<std::pair<std::string, std::unique_ptr<ConfigurationData>>> vtmDataList);
+	void stopVTMPreparation();
+
+	enum class VTMBuilderStatus {
+		idle,
+		running,
+		sent,     // the new model has been sent to the processor
+		finished, // the old model has been returned to the pool
+		failed
+	};
+	// The vocal tract model being built.
+	struct VTMBuild {
+		std::string key;
+		unsigned int qualityLevel;
+		std::vector<float> staticParamList;
+	};
+
 	State state_;
 	InteractiveVTMConfiguration& configuration_;
+	VocalTractModelPool vtmPool_;
+	std::vector<std::string> vtmKeyList_; // keys of the instances used by the processor
+	std::vector<float> staticParamList_; // of the instances used by the processor
 	Processor processor_; // must be accessed only by the JACK thread
-	std::unique_ptr<JackRingbuffer> parameterRingbuffer_;
-	std::unique_ptr<JackRingbuffer> analysisRingbuffer_;
+	std::unique_ptr<SharedParameterTable> parameterTable_;
+	std::unique_ptr<AnalysisQueue> analysisQueue_;
 	std::unique_ptr<JackClient> jackClient_;
 	unsigned int sampleRate_;
+	const ParameterTimeline* timeline_;
+	const ParameterTimeline* activeTimeline_;
+	std::unique_ptr<MIDIControlMap> midiControlMap_;
+	std::thread vtmBuilderThread_;
+	std::atomic<bool> stopVTMBuilder_;
+	std::atomic<VTMBuilderStatus> vtmBuilderStatus_;
+	std::string vtmBuilderError_; // written by the builder thread before the failed status
+	VTMBuild vtmBuild_;
+	bool vtmChangeRequested_; // will be started when the builder is idle
+	std::thread vtmPreparationThread_;
+	std::atomic<bool> stopVTMPreparation_;
+	unsigned int qualityLevel_; // of the instances used by the processor
+	unsigned long long governorBusyTime_;
+	unsigned long long governorProcessedFrames_;
+	unsigned int governorLowLoadCount_;
 };
 
 } /* namespace GS */
@@ -17,6 +17,10 @@
 
 #include "InteractiveVTMConfiguration.h"
 
+#include <fstream>
+#include <functional> /* hash */
+#include <iomanip>
+#include <iterator> /* istreambuf_iterator */
 #include <sstream>
 
 #include <QString>
@@ -25,9 +29,30 @@
 #include "global.h"
 
 #define CONFIG_FILE "interactive.config"
+#define DEFAULT_OUTPUT_LIMITER_ATTACK_TIME_MS (1.0f)
+#define DEFAULT_OUTPUT_LIMITER_RELEASE_TIME_MS (2000.0f)
+#define MAX_OUTPUT_LIMITER_TIME_MS (60000.0f)
+#define DEFAULT_OUTPUT_LIMITER_MIN_LEVEL (1.0e-2f)
+#define MIN_OUTPUT_LIMITER_MIN_LEVEL (1.0e-6f)
+#define DEFAULT_NUM_VOICES (1U)
+#define DEFAULT_GOVERNOR_TARGET_LOAD (0.0f)
+#define MAX_QUALITY_LEVEL_CHANGES (64U)
 
 
 
+namespace {
+
+// Identifies the contents of a file.
+std::size_t
+fileDigest(const std::string& filePath)
+{
+	std::ifstream in(filePath, std::ios_base::binary);
+	const std::string contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	return std::hash<std::string>()(contents);
+}
+
+} /* namespace */
+
 namespace GS {
 
 /*******************************************************************************
@@ -45,6 +70,17 @@ InteractiveVTMConfiguration::InteractiveVTMConfiguration(const char* configDirPa
 		, staticParamLabelList(staticParamNameList.size())
 		, staticParamMinList(  staticParamNameList.size())
 		, staticParamMaxList(  staticParamNameList.size())
+		, outputLimiterAttackTime{optionalValue("output_limiter_attack_time",
+					DEFAULT_OUTPUT_LIMITER_ATTACK_TIME_MS, 0.0f, MAX_OUTPUT_LIMITER_TIME_MS)}
+		, outputLimiterReleaseTime{optionalValue("output_limiter_release_time",
+					DEFAULT_OUTPUT_LIMITER_RELEASE_TIME_MS, 0.0f, MAX_OUTPUT_LIMITER_TIME_MS)}
+		, outputLimiterMinLevel{optionalValue("output_limiter_min_level",
+					DEFAULT_OUTPUT_LIMITER_MIN_LEVEL, MIN_OUTPUT_LIMITER_MIN_LEVEL, 1.0f)}
+		, numVoices{optionalValue("num_voices", DEFAULT_NUM_VOICES, 1U, static_cast<unsigned int>(MAX_VOICES))}
+		, governorTargetLoad{optionalValue("governor_target_load", DEFAULT_GOVERNOR_TARGET_LOAD, 0.0f, 1.0f)}
+		, numQualityLevels{optionalValue("num_quality_levels", 1U, 1U, static_cast<unsigned int>(MAX_QUALITY_LEVELS))}
+		, fileDigest_{}
+		, qualityLevelChangeList_(numQualityLevels - 1U)
 {
 	{
 		QString         nameKey{"dynamic_param-%1-name"};
@@ -86,8 +122,37 @@ InteractiveVTMConfiguration::InteractiveVTMConfiguration(const char* configDirPa
 		}
 	}
 
+	{
+		QString numChangesKey{"quality_level-%1-num_changes"};
+		QString     changeKey{"quality_level-%1-change-%2-key"};
+		QString   changeValue{"quality_level-%1-change-%2-value"};
+
+		for (std::size_t i = 0, size = qualityLevelChangeList_.size(); i < size; ++i) {
+			const unsigned int level = i + 1U;
+			const unsigned int numChanges = data->value<unsigned int>(numChangesKey.arg(level).toStdString(),
+											1U, MAX_QUALITY_LEVEL_CHANGES);
+			for (unsigned int j = 0; j < numChanges; ++j) {
+				qualityLevelChangeList_[i].emplace_back(
+						data->value<std::string>(  changeKey.arg(level).arg(j).toStdString()),
+						data->value<std::string>(changeValue.arg(level).arg(j).toStdString()));
+			}
+		}
+	}
+
+	try {
+		const std::string midiMappingFile = data->value<std::string>("midi_mapping_file");
+		midiMappingFilePath = configDirPath + '/' + midiMappingFile;
+	} catch (const Exception&) {
+		// Optional key.
+	}
+
 	vtmData = std::make_unique<ConfigurationData>(vtmConfigFilePath());
 	vtmData->insert(ConfigurationData(voiceConfigFilePath()));
+
+	// The other values that can be modified are added by vtmDataKey().
+	fileDigest_ = fileDigest(this->configDirPath + ("/" CONFIG_FILE)) ^
+			(fileDigest(vtmConfigFilePath()) * 31U) ^
+			(fileDigest(voiceConfigFilePath()) * 961U);
 }
 
 
@@ -125,6 +190,73 @@ InteractiveVTMConfiguration::setOutputRate(float value)
 	vtmData->put("output_rate", value);
 }
 
+std::string
+InteractiveVTMConfiguration::vtmDataKey() const
+{
+	std::ostringstream key;
+	key << configDirPath << '#' << std::hex << fileDigest_ << std::dec << std::setprecision(9)
+		<< "/output_rate=" << vtmData->value<float>("output_rate");
+	for (const std::string& name : staticParamNameList) {
+		key << '/' << name << '=' << vtmData->value<float>(name);
+	}
+	return key.str();
+}
+
+template<typename T>
+T
+InteractiveVTMConfiguration::optionalValue(const std::string& key, T defaultValue, T minValue, T maxValue) const
+{
+	T value;
+	try {
+		value = data->value<T>(key);
+	} catch (const Exception&) {
+		return defaultValue;
+	}
+	if (value < minValue || value > maxValue) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid value for " << key << ": " << value
+				<< " (should be in the range [" << minValue << ", " << maxValue << "]).");
+	}
+	return value;
+}
+
+std::unique_ptr<ConfigurationData>
+InteractiveVTMConfiguration::voiceVTMData(unsigned int voice, unsigned int qualityLevel) const
+{
+	if (voice >= numVoices) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid voice: " << voice << '.');
+	}
+	if (qualityLevel >= numQualityLevels) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid quality level: " << qualityLevel << '.');
+	}
+
+	auto voiceData = std::make_unique<ConfigurationData>(*vtmData);
+
+	if (voice > 0) {
+		QString key{"voice-%1-%2"};
+		for (std::size_t i = 0, size = staticParamNameList.size(); i < size; ++i) {
+			const float value = optionalValue(key.arg(voice).arg(staticParamNameList[i].c_str()).toStdString(),
+								voiceData->value<float>(staticParamNameList[i]),
+								staticParamMinList[i], staticParamMaxList[i]);
+			voiceData->put(staticParamNameList[i], value);
+		}
+	}
+
+	if (qualityLevel > 0) {
+		for (const auto& change : qualityLevelChangeList_[qualityLevel - 1U]) {
+			voiceData->put(change.first, change.second);
+		}
+	}
+	return voiceData;
+}
+
+std::string
+InteractiveVTMConfiguration::voiceVTMDataKey(unsigned int voice, unsigned int qualityLevel) const
+{
+	std::ostringstream key;
+	key << vtmDataKey() << "/voice-" << voice << "/quality-" << qualityLevel;
+	return key.str();
+}
+
 std::string
 InteractiveVTMConfiguration::vtmConfigFilePath() const
 {
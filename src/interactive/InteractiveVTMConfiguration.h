@@ -18,8 +18,10 @@
 #ifndef INTERACTIVE_VTM_CONFIGURATION_H_
 #define INTERACTIVE_VTM_CONFIGURATION_H_
 
+#include <cstddef> /* std::size_t */
 #include <memory>
 #include <string>
+#include <utility> /* pair */
 #include <vector>
 
 #include <ConfigurationData.h>
@@ -30,6 +32,11 @@ namespace GS {
 
 struct InteractiveVTMConfiguration {
 public:
+	enum {
+		MAX_VOICES = 16,
+		MAX_QUALITY_LEVELS = 16
+	};
+
 	std::string configDirPath;
 	std::unique_ptr<ConfigurationData> data;
 	std::unique_ptr<ConfigurationData> vtmData;
@@ -45,6 +52,27 @@ public:
 	std::vector<float>       staticParamMinList;
 	std::vector<float>       staticParamMaxList;
 
+	// Output level normalization (optional keys).
+	float outputLimiterAttackTime;  // ms
+	float outputLimiterReleaseTime; // ms
+	float outputLimiterMinLevel;    // peak level with the maximum gain (nominal speech level)
+
+	// Number of vocal tract models played together (optional key).
+	unsigned int numVoices;
+
+	// CPU load governor (optional keys).
+	// The governor selects a quality level to keep the load of the JACK
+	// callback below the target. Level 0 uses vtmData without changes.
+	// Each level i > 0 replaces values of vtmData, using the keys
+	// quality_level-<i>-change-<j>-key and quality_level-<i>-change-<j>-value.
+	// The levels must be ordered from the most to the least expensive.
+	float governorTargetLoad; // 0.0: disabled
+	unsigned int numQualityLevels; // including the level 0
+
+	// Mapping of MIDI messages to dynamic parameters (optional key
+	// midi_mapping_file). If empty, the MIDI input is disabled.
+	std::string midiMappingFilePath;
+
 	InteractiveVTMConfiguration(const char* configDirPath);
 
 	// Reloads the configuration file.
@@ -54,9 +82,28 @@ public:
 	float staticParameter(int parameter);
 	void setStaticParameter(int parameter, float value);
 	void setOutputRate(float value);
+
+	// Identifies the current contents of vtmData, using the contents of the
+	// configuration files and the values that can be modified.
+	// Returning to previous values returns the previous key.
+	std::string vtmDataKey() const;
+
+	// Returns the configuration of the vocal tract model of a voice.
+	// The voice 0 uses vtmData. The other voices use a copy of vtmData,
+	// with the static parameters replaced by the values of the optional keys
+	// voice-<voice>-<static parameter name> in the configuration file.
+	// Then the changes of the quality level are applied.
+	std::unique_ptr<ConfigurationData> voiceVTMData(unsigned int voice, unsigned int qualityLevel = 0) const;
+	std::string voiceVTMDataKey(unsigned int voice, unsigned int qualityLevel = 0) const;
 private:
+	// Returns defaultValue if the key is not present.
+	template<typename T> T optionalValue(const std::string& key, T defaultValue, T minValue, T maxValue) const;
 	std::string vtmConfigFilePath() const;
 	std::string voiceConfigFilePath() const;
+
+	std::size_t fileDigest_; // of the configuration files
+	// Index: quality level - 1.
+	std::vector<std::vector<std::pair<std::string, std::string>>> qualityLevelChangeList_;
 };
 
 } /* namespace GS */
@@ -17,7 +17,7 @@
 
 #include "InteractiveVTMWindow.h"
 
-#include <cassert>
+#include <iostream>
 
 #include <QAction>
 #include <QApplication>
@@ -45,6 +45,8 @@
 #include "ConfigurationData.h"
 #include "ParameterLineEdit.h"
 #include "ParameterSlider.h"
+#include "ParameterTimeline.h"
+#include "TimelineRenderer.h"
 
 
 
@@ -57,13 +59,13 @@ InteractiveVTMWindow::InteractiveVTMWindow(const char* configDirPath, bool mainW
 		: QMainWindow{parent}
 		, mainWindow_{mainWindow}
 		, configuration_{std::make_unique<InteractiveVTMConfiguration>(configDirPath)}
-		, transferTimer_{}
+		, governorTimer_{}
+		, vtmChangeTimer_{}
 		, dynamicParamSliderList_(configuration_->dynamicParamNameList.size())
 		, dynamicParamEditList_(  configuration_->dynamicParamNameList.size())
 		, staticParamSliderList_( configuration_->staticParamNameList.size())
 		, staticParamEditList_(   configuration_->staticParamNameList.size())
 		, audio_{std::make_unique<InteractiveAudio>(*configuration_)}
-		, dynamicParameterValueChanged_{false}
 		, analysisWindow_{std::make_unique<AnalysisWindow>()}
 {
 	setWindowIcon(QIcon{":/img/window_icon.png"});
@@ -86,11 +88,21 @@ InteractiveVTMWindow::InteractiveVTMWindow(const char* configDirPath, bool mainW
 	layout->setStretch(1, 1);
 	setWindowTitle(INTERACTIVE_NAME);
 
-	// Transfer timer.
-	transferTimer_ = new QTimer(this);
-	transferTimer_->setTimerType(Qt::PreciseTimer);
-	connect(transferTimer_, &QTimer::timeout, this, &InteractiveVTMWindow::transferDynamicParameter);
-	transferTimer_->start(TRANSFER_TIMER_TIMEOUT_MS);
+	// CPU load governor.
+	governorTimer_ = new QTimer(this);
+	connect(governorTimer_, &QTimer::timeout, this, &InteractiveVTMWindow::updateGovernor);
+	governorTimer_->start(GOVERNOR_TIMER_INTERVAL_MS);
+
+	// Changes of vocal tract model without restarting the audio.
+	vtmChangeTimer_ = new QTimer(this);
+	connect(vtmChangeTimer_, &QTimer::timeout, this, &InteractiveVTMWindow::updateVocalTractModel);
+	vtmChangeTimer_->start(VTM_CHANGE_TIMER_INTERVAL_MS);
+
+	try {
+		audio_->prepareVocalTractModels();
+	} catch (std::exception& exc) {
+		std::cerr << "[InteractiveVTMWindow::InteractiveVTMWindow] Caught exception: " << exc.what() << '.' << std::endl;
+	}
 }
 
 /*******************************************************************************
@@ -111,6 +123,8 @@ InteractiveVTMWindow::initMenu()
 
 	QAction* loadDynamicParametersAction = new QAction(tr("Load Dynamic Parameters"), this);
 	QAction* saveDynamicParametersAction = new QAction(tr("Save Dynamic Parameters"), this);
+	QAction* loadTimelineAction          = new QAction(tr("Load Timeline"), this);
+	QAction* renderTimelineAction        = new QAction(tr("Render Timeline to File"), this);
 	QAction* exitAction {};
 	if (mainWindow_) {
 		exitAction = new QAction(tr("E&xit"), this);
@@ -119,6 +133,8 @@ InteractiveVTMWindow::initMenu()
 
 	connect(loadDynamicParametersAction, &QAction::triggered, this, &InteractiveVTMWindow::loadDynamicParameters);
 	connect(saveDynamicParametersAction, &QAction::triggered, this, &InteractiveVTMWindow::saveDynamicParameters);
+	connect(loadTimelineAction         , &QAction::triggered, this, &InteractiveVTMWindow::loadTimeline);
+	connect(renderTimelineAction       , &QAction::triggered, this, &InteractiveVTMWindow::renderTimeline);
 	if (mainWindow_) {
 		connect(exitAction         , &QAction::triggered, qApp, &QApplication::closeAllWindows);
 	}
@@ -130,6 +146,9 @@ InteractiveVTMWindow::initMenu()
 	QMenu* fileMenu = menuBar()->addMenu(tr("&File"));
 	fileMenu->addAction(loadDynamicParametersAction);
 	fileMenu->addAction(saveDynamicParametersAction);
+	fileMenu->addSeparator();
+	fileMenu->addAction(loadTimelineAction);
+	fileMenu->addAction(renderTimelineAction);
 	if (mainWindow_) {
 		fileMenu->addSeparator();
 		fileMenu->addAction(exitAction);
@@ -151,6 +170,7 @@ InteractiveVTMWindow::initButtons(QWidget* parent)
 	QPushButton* copyDynamicParametersButton  = new QPushButton(tr("Copy dyn. parameters"), widget);
 	QPushButton* startAudioButton             = new QPushButton(tr("(Re)start"), widget);
 	QPushButton* stopAudioButton              = new QPushButton(tr("Stop"), widget);
+	QPushButton* playTimelineButton           = new QPushButton(tr("Play timeline"), widget);
 	QPushButton* reloadButton                 = new QPushButton(tr("Reload Configuration"), widget);
 	QPushButton* analysisButton               = new QPushButton(tr("Analysis"), widget);
 
@@ -160,6 +180,7 @@ InteractiveVTMWindow::initButtons(QWidget* parent)
 	layout->addWidget(copyDynamicParametersButton);
 	layout->addWidget(startAudioButton);
 	layout->addWidget(stopAudioButton);
+	layout->addWidget(playTimelineButton);
 	layout->addWidget(reloadButton);
 	layout->addWidget(analysisButton);
 
@@ -167,6 +188,7 @@ InteractiveVTMWindow::initButtons(QWidget* parent)
 	connect(copyDynamicParametersButton , &QPushButton::clicked, this, &InteractiveVTMWindow::copyDynamicParameters);
 	connect(startAudioButton            , &QPushButton::clicked, this, &InteractiveVTMWindow::startAudio);
 	connect(stopAudioButton             , &QPushButton::clicked, this, &InteractiveVTMWindow::stopAudio);
+	connect(playTimelineButton          , &QPushButton::clicked, this, &InteractiveVTMWindow::playTimeline);
 	connect(reloadButton                , &QPushButton::clicked, this, &InteractiveVTMWindow::reload);
 	connect(analysisButton              , &QPushButton::clicked, this, &InteractiveVTMWindow::showAnalysisWindow);
 
@@ -301,10 +323,11 @@ void
 InteractiveVTMWindow::startAudio()
 {
 	try {
+		audio_->setTimeline(nullptr);
 		transferAllDynamicParameters();
 		audio_->start();
 
-		analysisWindow_->setData(audio_->sampleRate(), &audio_->analysisRingbuffer(), InteractiveAudio::MAX_NUM_SAMPLES_FOR_ANALYSIS);
+		analysisWindow_->setData(audio_->sampleRate(), &audio_->analysisQueue(), InteractiveAudio::MAX_NUM_SAMPLES_FOR_ANALYSIS);
 	} catch (std::exception& exc) {
 		QMessageBox::critical(this, tr("Error"), tr("Could not start audio. Reason: %1").arg(exc.what()));
 	}
@@ -334,9 +357,7 @@ InteractiveVTMWindow::stopAudio()
 void
 InteractiveVTMWindow::setDynamicParameter(int parameter, float value)
 {
-	dynamicParameterValue_.index = parameter;
-	dynamicParameterValue_.value = value;
-	dynamicParameterValueChanged_ = true;
+	audio_->parameterTable().set(parameter, value);
 }
 
 /*******************************************************************************
@@ -349,48 +370,15 @@ InteractiveVTMWindow::setStaticParameter(int parameter, float value)
 	configuration_->setStaticParameter(parameter, value);
 }
 
-/*******************************************************************************
- *
- */
-// Slot.
-void
-InteractiveVTMWindow::transferDynamicParameter()
-{
-	if (dynamicParameterValueChanged_) {
-		JackRingbuffer& rb = audio_->parameterRingbuffer();
-
-		const size_t elementSize = sizeof(VocalTractModelParameterValue);
-		if (rb.writeSpace() >= elementSize) {
-#ifndef NDEBUG
-			size_t bytesWritten =
-#endif
-			rb.write(reinterpret_cast<const char*>(&dynamicParameterValue_), elementSize);
-			assert(bytesWritten == elementSize);
-			dynamicParameterValueChanged_ = false;
-		}
-	}
-}
-
 /*******************************************************************************
  *
  */
 void
 InteractiveVTMWindow::transferAllDynamicParameters()
 {
-	JackRingbuffer& rb = audio_->parameterRingbuffer();
-
-	const size_t elementSize = sizeof(VocalTractModelParameterValue);
-	VocalTractModelParameterValue pv;
+	SharedParameterTable& table = audio_->parameterTable();
 	for (std::size_t i = 0, size = configuration_->dynamicParamNameList.size(); i < size; ++i) {
-		pv.index = i;
-		pv.value = dynamicParamEditList_[i]->parameterValue();
-		if (rb.writeSpace() >= elementSize) {
-#ifndef NDEBUG
-			size_t bytesWritten =
-#endif
-			rb.write(reinterpret_cast<const char*>(&pv), elementSize);
-			assert(bytesWritten == elementSize);
-		}
+		table.set(i, dynamicParamEditList_[i]->parameterValue());
 	}
 }
 
@@ -452,6 +440,104 @@ InteractiveVTMWindow::saveDynamicParameters()
 	}
 }
 
+/*******************************************************************************
+ *
+ */
+// Slot.
+void
+InteractiveVTMWindow::loadTimeline()
+{
+	QString fileName = QFileDialog::getOpenFileName(this, tr("Load Timeline:"), currentTimelineFileName_, tr("Text files (*.txt)"));
+	if (fileName.isEmpty()) {
+		return;
+	}
+
+	std::unique_ptr<ParameterTimeline> newTimeline;
+	try {
+		newTimeline = std::make_unique<ParameterTimeline>(fileName.toStdString(),
+									configuration_->dynamicParamNameList,
+									configuration_->dynamicParamMinList,
+									configuration_->dynamicParamMaxList);
+	} catch (std::exception& exc) {
+		QMessageBox::critical(this, tr("Error"), tr("Could not load the timeline file %1. Reason: %2").arg(fileName).arg(exc.what()));
+		return;
+	}
+	currentTimelineFileName_ = fileName;
+
+	// The audio may be playing the old timeline.
+	if (timeline_ && audio_->activeTimeline() == timeline_.get()) {
+		stopAudio();
+	}
+	audio_->setTimeline(nullptr);
+	timeline_ = std::move(newTimeline);
+}
+
+/*******************************************************************************
+ * Plays the timeline from the beginning.
+ *
+ * The parameters that are not in the timeline are controlled by the sliders.
+ */
+// Slot.
+void
+InteractiveVTMWindow::playTimeline()
+{
+	if (!timeline_) {
+		QMessageBox::information(this, tr("Timeline"), tr("No timeline loaded."));
+		return;
+	}
+
+	try {
+		audio_->setTimeline(timeline_.get());
+		transferAllDynamicParameters();
+		audio_->start();
+
+		analysisWindow_->setData(audio_->sampleRate(), &audio_->analysisQueue(), InteractiveAudio::MAX_NUM_SAMPLES_FOR_ANALYSIS);
+	} catch (std::exception& exc) {
+		QMessageBox::critical(this, tr("Error"), tr("Could not start audio. Reason: %1").arg(exc.what()));
+	}
+}
+
+/*******************************************************************************
+ * Renders the timeline to a file, without JACK.
+ *
+ * The parameters that are not in the timeline use the values of the sliders.
+ */
+// Slot.
+void
+InteractiveVTMWindow::renderTimeline()
+{
+	if (!timeline_) {
+		QMessageBox::information(this, tr("Timeline"), tr("No timeline loaded."));
+		return;
+	}
+
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Save file"), QString(), tr("WAV files (*.wav)"));
+	if (fileName.isEmpty()) {
+		return;
+	}
+
+	std::vector<float> paramValues(configuration_->dynamicParamNameList.size());
+	for (std::size_t i = 0, size = paramValues.size(); i < size; ++i) {
+		paramValues[i] = dynamicParamEditList_[i]->parameterValue();
+	}
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	try {
+		std::vector<float> signal;
+		const TimelineRenderer::Result result = TimelineRenderer::render(*timeline_, *configuration_->vtmData, paramValues, signal);
+		TimelineRenderer::writeWAVFile(signal, static_cast<unsigned int>(result.outputSampleRate), fileName.toStdString());
+		QApplication::restoreOverrideCursor();
+
+		QMessageBox::information(this, tr("Timeline"), tr("Rendered %1 s of audio in %2 s (%3 x real time).")
+						.arg(result.audioDuration)
+						.arg(result.renderTime)
+						.arg(result.renderTime > 0.0 ? result.audioDuration / result.renderTime : 0.0));
+	} catch (std::exception& exc) {
+		QApplication::restoreOverrideCursor();
+		QMessageBox::critical(this, tr("Error"), tr("Could not render the timeline. Reason: %1").arg(exc.what()));
+	}
+}
+
 /*******************************************************************************
  *
  */
@@ -549,6 +635,15 @@ InteractiveVTMWindow::showAnalysisWindow()
 void
 InteractiveVTMWindow::applyStaticParameters()
 {
+	try {
+		if (audio_->updateStaticParameters()) {
+			return;
+		}
+	} catch (std::exception& exc) {
+		QMessageBox::critical(this, tr("Error"), tr("Could not apply the static parameters. Reason: %1").arg(exc.what()));
+		return;
+	}
+
 	try {
 		audio_->stop();
 	} catch (std::exception& exc) {
@@ -564,6 +659,44 @@ InteractiveVTMWindow::applyStaticParameters()
 	}
 }
 
+/*******************************************************************************
+ *
+ */
+// Slot.
+void
+InteractiveVTMWindow::updateVocalTractModel()
+{
+	std::string errorMessage;
+	try {
+		if (audio_->updateVocalTractModel(errorMessage)) {
+			return;
+		}
+	} catch (std::exception& exc) {
+		QMessageBox::critical(this, tr("Error"), tr("Could not apply the static parameters. Reason: %1").arg(exc.what()));
+		return;
+	}
+
+	// The previous static parameters have been restored.
+	for (std::size_t i = 0, size = staticParamEditList_.size(); i < size; ++i) {
+		staticParamEditList_[i]->setParameterValue(configuration_->staticParameter(i));
+	}
+	QMessageBox::critical(this, tr("Error"), tr("Could not apply the static parameters. Reason: %1").arg(errorMessage.c_str()));
+}
+
+/*******************************************************************************
+ *
+ */
+// Slot.
+void
+InteractiveVTMWindow::updateGovernor()
+{
+	try {
+		audio_->updateGovernor();
+	} catch (std::exception& exc) {
+		std::cerr << "[InteractiveVTMWindow::updateGovernor] Caught exception: " << exc.what() << '.' << std::endl;
+	}
+}
+
 /*******************************************************************************
  *
  */
@@ -598,10 +731,14 @@ InteractiveVTMWindow::reload()
 	}
 
 	try {
+		// The models of the old configuration files are not reused.
+		audio_->stop();
+		audio_->clearVocalTractModels();
+
 		transferAllDynamicParameters();
 		audio_->start();
 
-		analysisWindow_->setData(audio_->sampleRate(), &audio_->analysisRingbuffer(), InteractiveAudio::MAX_NUM_SAMPLES_FOR_ANALYSIS);
+		analysisWindow_->setData(audio_->sampleRate(), &audio_->analysisQueue(), InteractiveAudio::MAX_NUM_SAMPLES_FOR_ANALYSIS);
 	} catch (std::exception& exc) {
 		QMessageBox::critical(this, tr("Error"), tr("Could not start audio. Reason: %1").arg(exc.what()));
 	}
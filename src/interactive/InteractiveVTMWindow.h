@@ -26,7 +26,6 @@
 
 #include "InteractiveAudio.h"
 #include "InteractiveVTMConfiguration.h"
-#include "VocalTractModelParameterValue.h"
 
 
 
@@ -39,6 +38,7 @@ namespace GS {
 class AnalysisWindow;
 class ParameterLineEdit;
 class ParameterSlider;
+class ParameterTimeline;
 
 class InteractiveVTMWindow : public QMainWindow {
 	Q_OBJECT
@@ -57,9 +57,13 @@ private slots:
 	void setDynamicParameter(int parameter, float value);
 	void loadDynamicParameters();
 	void saveDynamicParameters();
+	void loadTimeline();
+	void playTimeline();
+	void renderTimeline();
 	void setStaticParameter(int parameter, float value);
 	void applyStaticParameters();
-	void transferDynamicParameter();
+	void updateVocalTractModel();
+	void updateGovernor();
 	void reload();
 	void about();
 	void showAnalysisWindow();
@@ -67,7 +71,8 @@ signals:
 	void destructionRequested();
 private:
 	enum {
-		TRANSFER_TIMER_TIMEOUT_MS = 25
+		GOVERNOR_TIMER_INTERVAL_MS = 500,
+		VTM_CHANGE_TIMER_INTERVAL_MS = 50
 	};
 
 	InteractiveVTMWindow(const InteractiveVTMWindow&) = delete;
@@ -82,15 +87,16 @@ private:
 
 	bool mainWindow_;
 	std::unique_ptr<InteractiveVTMConfiguration> configuration_;
-	QTimer* transferTimer_;
+	QTimer* governorTimer_;
+	QTimer* vtmChangeTimer_;
 	std::vector<ParameterSlider*>   dynamicParamSliderList_;
 	std::vector<ParameterLineEdit*> dynamicParamEditList_;
 	std::vector<ParameterSlider*>   staticParamSliderList_;
 	std::vector<ParameterLineEdit*> staticParamEditList_;
 	std::unique_ptr<InteractiveAudio> audio_;
 	QString currentParametersFileName_;
-	VocalTractModelParameterValue dynamicParameterValue_;
-	bool dynamicParameterValueChanged_;
+	QString currentTimelineFileName_;
+	std::unique_ptr<ParameterTimeline> timeline_;
 	std::unique_ptr<AnalysisWindow> analysisWindow_;
 };
 
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "MIDIControlMap.h"
+
+#include <algorithm> /* find, replace */
+#include <fstream>
+#include <iterator> /* begin, end */
+#include <sstream>
+
+#include "Exception.h"
+
+#define MIDI_STATUS_CONTROL_CHANGE 0xB0
+#define MIDI_STATUS_PITCH_BEND 0xE0
+#define MIDI_MAX_CONTROLLER_VALUE (127.0f)
+#define MIDI_MAX_PITCH_BEND_VALUE (16383.0f)
+
+
+
+namespace GS {
+
+MIDIControlMap::MIDIControlMap(const std::string& filePath,
+				const std::vector<std::string>& paramNameList,
+				const std::vector<float>& paramMinList,
+				const std::vector<float>& paramMaxList)
+{
+	for (auto& channelTable : controllerTable_) {
+		std::fill(std::begin(channelTable), std::end(channelTable), static_cast<int>(NO_MAPPING));
+	}
+	std::fill(std::begin(pitchBendTable_), std::end(pitchBendTable_), static_cast<int>(NO_MAPPING));
+
+	std::ifstream in(filePath);
+	if (!in) {
+		THROW_EXCEPTION(IOException, "Could not open the file " << filePath << '.');
+	}
+
+	std::vector<std::string> nameList(paramNameList);
+	for (auto& name : nameList) {
+		std::replace(name.begin(), name.end(), ' ', '_');
+	}
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(in, line)) {
+		++lineNumber;
+		std::istringstream lineStream(line);
+		lineStream >> std::ws;
+		if (lineStream.eof() || lineStream.peek() == '#') {
+			continue;
+		}
+
+		std::string type, channelText, name;
+		int controller = 0;
+		if (!(lineStream >> type >> channelText)) {
+			THROW_EXCEPTION(InvalidValueException, "Invalid line " << lineNumber << " in the file " << filePath << '.');
+		}
+		if (type == "cc") {
+			if (!(lineStream >> controller) || controller < 0 || controller >= NUM_CONTROLLERS) {
+				THROW_EXCEPTION(InvalidValueException, "Invalid controller in line " << lineNumber << " of the file " << filePath << '.');
+			}
+		} else if (type != "pitch_bend") {
+			THROW_EXCEPTION(InvalidValueException, "Invalid message type in line " << lineNumber << " of the file " << filePath
+					<< ": " << type << '.');
+		}
+		if (!(lineStream >> name)) {
+			THROW_EXCEPTION(InvalidValueException, "Invalid line " << lineNumber << " in the file " << filePath << '.');
+		}
+
+		int channel = -1; // all
+		if (channelText != "*") {
+			std::istringstream channelStream(channelText);
+			if (!(channelStream >> channel) || channel < 1 || channel > NUM_CHANNELS) {
+				THROW_EXCEPTION(InvalidValueException, "Invalid channel in line " << lineNumber << " of the file " << filePath
+						<< ": " << channelText << '.');
+			}
+			--channel;
+		}
+
+		const auto iter = std::find(nameList.begin(), nameList.end(), name);
+		if (iter == nameList.end()) {
+			THROW_EXCEPTION(InvalidValueException, "Unknown parameter in line " << lineNumber << " of the file " << filePath
+					<< ": " << name << '.');
+		}
+
+		Mapping mapping;
+		mapping.parameter = iter - nameList.begin();
+		mapping.minValue = paramMinList[mapping.parameter];
+		mapping.maxValue = paramMaxList[mapping.parameter];
+		float minValue, maxValue;
+		if (lineStream >> minValue) {
+			if (!(lineStream >> maxValue)) {
+				THROW_EXCEPTION(InvalidValueException, "Missing maximum value in line " << lineNumber << " of the file " << filePath << '.');
+			}
+			for (float v : {minValue, maxValue}) {
+				if (v < mapping.minValue || v > mapping.maxValue) {
+					THROW_EXCEPTION(InvalidValueException, "Value out of range in line " << lineNumber << " of the file " << filePath
+							<< ": " << v << '.');
+				}
+			}
+			mapping.minValue = minValue;
+			mapping.maxValue = maxValue;
+		}
+
+		mappingList_.push_back(mapping);
+		const int mappingIndex = mappingList_.size() - 1;
+		if (type == "cc") {
+			setMapping(channel, &controllerTable_[0][controller], NUM_CONTROLLERS, mappingIndex);
+		} else {
+			setMapping(channel, pitchBendTable_, 1, mappingIndex);
+		}
+	}
+}
+
+// channel: -1 for all the channels.
+void
+MIDIControlMap::setMapping(int channel, int* table, std::size_t tableStride, int mapping)
+{
+	if (channel < 0) {
+		for (int i = 0; i < NUM_CHANNELS; ++i) {
+			table[i * tableStride] = mapping;
+		}
+	} else {
+		table[channel * tableStride] = mapping;
+	}
+}
+
+bool
+MIDIControlMap::convert(const unsigned char* message, std::size_t size, std::size_t& parameter, float& value) const
+{
+	if (size < 3) return false;
+
+	const unsigned int channel = message[0] & 0x0F;
+	int mappingIndex;
+	float position; // [0.0, 1.0]
+	switch (message[0] & 0xF0) {
+	case MIDI_STATUS_CONTROL_CHANGE:
+		mappingIndex = controllerTable_[channel][message[1] & 0x7F];
+		position = (message[2] & 0x7F) / MIDI_MAX_CONTROLLER_VALUE;
+		break;
+	case MIDI_STATUS_PITCH_BEND:
+		mappingIndex = pitchBendTable_[channel];
+		position = (((message[2] & 0x7F) << 7) | (message[1] & 0x7F)) / MIDI_MAX_PITCH_BEND_VALUE;
+		break;
+	default:
+		return false;
+	}
+	if (mappingIndex == NO_MAPPING) return false;
+
+	const Mapping& mapping = mappingList_[mappingIndex];
+	parameter = mapping.parameter;
+	value = mapping.minValue + position * (mapping.maxValue - mapping.minValue);
+	return true;
+}
+
+} /* namespace GS */
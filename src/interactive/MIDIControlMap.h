@@ -0,0 +1,76 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef MIDI_CONTROL_MAP_H
+#define MIDI_CONTROL_MAP_H
+
+#include <cstddef> /* std::size_t */
+#include <string>
+#include <vector>
+
+
+
+namespace GS {
+
+// Maps MIDI control change and pitch bend messages to dynamic parameters.
+//
+// File format (one mapping per line):
+//
+//     cc <channel> <controller> <parameter name> [<min value> <max value>]
+//     pitch_bend <channel> <parameter name> [<min value> <max value>]
+//
+// channel: 1-16, or '*' for all the channels.
+// Spaces in the parameter names must be replaced by '_'.
+// Empty lines and lines starting with '#' are ignored.
+//
+// The MIDI value range is mapped linearly to [min value, max value]
+// (default: the range of the parameter). min value may be greater than
+// max value, to invert the control.
+class MIDIControlMap {
+public:
+	MIDIControlMap(const std::string& filePath,
+			const std::vector<std::string>& paramNameList,
+			const std::vector<float>& paramMinList,
+			const std::vector<float>& paramMaxList);
+
+	// Converts a MIDI message. Returns false if the message is not mapped.
+	// Can be called by the JACK thread.
+	bool convert(const unsigned char* message, std::size_t size, std::size_t& parameter, float& value) const;
+private:
+	enum {
+		NUM_CHANNELS = 16,
+		NUM_CONTROLLERS = 128,
+		NO_MAPPING = -1
+	};
+
+	struct Mapping {
+		std::size_t parameter;
+		float minValue;
+		float maxValue;
+	};
+
+	void setMapping(int channel, int* table, std::size_t tableStride, int mapping);
+
+	std::vector<Mapping> mappingList_;
+	int controllerTable_[NUM_CHANNELS][NUM_CONTROLLERS]; // indexes of mappingList_
+	int pitchBendTable_[NUM_CHANNELS];
+};
+
+} /* namespace GS */
+
+#endif // MIDI_CONTROL_MAP_H
@@ -0,0 +1,120 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "MovingAverageFilterBank.h"
+
+#include <algorithm> /* copy, fill */
+#include <utility> /* swap */
+#include <cmath> /* rint */
+
+#ifdef __SSE__
+# include <xmmintrin.h>
+#endif
+
+
+
+namespace GS {
+
+MovingAverageFilterBank::MovingAverageFilterBank()
+		: numFilters_{}
+		, numTaps_{1}
+		, pos_{}
+		, invNumTaps_{1.0}
+{
+}
+
+MovingAverageFilterBank::~MovingAverageFilterBank()
+{
+}
+
+void
+MovingAverageFilterBank::reset(std::size_t numberOfFilters, float sampleRate, float period)
+{
+	const float n = std::rint(sampleRate * period);
+	numTaps_ = (n < 1.0f) ? 1 : static_cast<std::size_t>(n);
+	numFilters_ = numberOfFilters;
+	pos_ = 0;
+	invNumTaps_ = 1.0f / numTaps_;
+
+	history_.resize(numTaps_ * numFilters_);
+	std::fill(history_.begin(), history_.end(), 0.0f);
+	sums_.resize(numFilters_);
+	std::fill(sums_.begin(), sums_.end(), 0.0f);
+	cycleSums_.resize(numFilters_);
+	std::fill(cycleSums_.begin(), cycleSums_.end(), 0.0f);
+}
+
+void
+MovingAverageFilterBank::filter(const float* input, float* output)
+{
+	float* hist = history_.data() + pos_ * numFilters_;
+	float* sum = sums_.data();
+	float* cycleSum = cycleSums_.data();
+
+	std::size_t i = 0;
+#ifdef __SSE__
+	const __m128 invN = _mm_set1_ps(invNumTaps_);
+	for ( ; i + 4 <= numFilters_; i += 4) {
+		const __m128 x = _mm_loadu_ps(input + i);
+		const __m128 s = _mm_add_ps(_mm_loadu_ps(sum + i), _mm_sub_ps(x, _mm_loadu_ps(hist + i)));
+		_mm_storeu_ps(sum + i, s);
+		_mm_storeu_ps(cycleSum + i, _mm_add_ps(_mm_loadu_ps(cycleSum + i), x));
+		_mm_storeu_ps(hist + i, x);
+		_mm_storeu_ps(output + i, _mm_mul_ps(s, invN));
+	}
+#endif
+	for ( ; i < numFilters_; ++i) {
+		sum[i] += input[i] - hist[i];
+		cycleSum[i] += input[i];
+		hist[i] = input[i];
+		output[i] = sum[i] * invNumTaps_;
+	}
+
+	if (++pos_ == numTaps_) {
+		// All the history has been replaced in this cycle.
+		pos_ = 0;
+		sums_.swap(cycleSums_);
+		std::fill(cycleSums_.begin(), cycleSums_.end(), 0.0f);
+	}
+}
+
+void
+MovingAverageFilterBank::fill(const float* input)
+{
+	for (std::size_t tap = 0; tap < numTaps_; ++tap) {
+		std::copy(input, input + numFilters_, history_.data() + tap * numFilters_);
+	}
+	pos_ = 0;
+	for (std::size_t i = 0; i < numFilters_; ++i) {
+		sums_[i] = input[i] * numTaps_;
+	}
+	std::fill(cycleSums_.begin(), cycleSums_.end(), 0.0f);
+}
+
+void
+MovingAverageFilterBank::swap(MovingAverageFilterBank& other)
+{
+	std::swap(numFilters_, other.numFilters_);
+	std::swap(numTaps_, other.numTaps_);
+	std::swap(pos_, other.pos_);
+	std::swap(invNumTaps_, other.invNumTaps_);
+	history_.swap(other.history_);
+	sums_.swap(other.sums_);
+	cycleSums_.swap(other.cycleSums_);
+}
+
+} /* namespace GS */
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef MOVING_AVERAGE_FILTER_BANK_H
+#define MOVING_AVERAGE_FILTER_BANK_H
+
+#include <cstddef> /* std::size_t */
+#include <vector>
+
+
+
+namespace GS {
+
+// Set of moving average filters with the same length, processed together.
+//
+// The history is stored tap by tap, with the values of all the filters
+// contiguous, so that each step processes the filters in SIMD lanes.
+//
+// The running sums would accumulate rounding errors. A second set of sums
+// accumulates the inputs of the current cycle of the history, and replaces
+// the running sums when the cycle is complete. The cost per step is constant.
+class MovingAverageFilterBank {
+public:
+	MovingAverageFilterBank();
+	~MovingAverageFilterBank();
+
+	// period: seconds
+	// Allocates memory only if the size changes.
+	void reset(std::size_t numberOfFilters, float sampleRate, float period);
+
+	// input and output must point to arrays of size numberOfFilters().
+	void filter(const float* input, float* output);
+
+	// Sets the history of each filter to a constant value, so that the output
+	// starts at input without a transient.
+	// input must point to an array of size numberOfFilters().
+	// Does not allocate memory.
+	void fill(const float* input);
+
+	// Does not allocate memory.
+	void swap(MovingAverageFilterBank& other);
+
+	std::size_t numberOfFilters() const { return numFilters_; }
+private:
+	MovingAverageFilterBank(const MovingAverageFilterBank&) = delete;
+	MovingAverageFilterBank& operator=(const MovingAverageFilterBank&) = delete;
+
+	std::size_t numFilters_;
+	std::size_t numTaps_;
+	std::size_t pos_;
+	float invNumTaps_;
+	std::vector<float> history_; // numTaps_ x numFilters_
+	std::vector<float> sums_;
+	std::vector<float> cycleSums_; // sums of the inputs since pos_ was 0
+};
+
+} /* namespace GS */
+
+#endif // MOVING_AVERAGE_FILTER_BANK_H
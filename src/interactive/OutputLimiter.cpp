@@ -0,0 +1,125 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "OutputLimiter.h"
+
+#include <algorithm> /* max, min */
+#include <cmath> /* abs, exp */
+
+#ifdef __SSE__
+# include <xmmintrin.h>
+#endif
+
+#include "VTMUtil.h"
+
+#define DEFAULT_MIN_LEVEL (1.0e-2f)
+
+
+
+namespace {
+
+float
+maximumAbsoluteValue(const float* buffer, std::size_t n)
+{
+	std::size_t i = 0;
+	float maxValue = 0.0f;
+#ifdef __SSE__
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 maxV = _mm_setzero_ps();
+	for ( ; i + 4 <= n; i += 4) {
+		maxV = _mm_max_ps(maxV, _mm_andnot_ps(signMask, _mm_loadu_ps(buffer + i)));
+	}
+	maxV = _mm_max_ps(maxV, _mm_movehl_ps(maxV, maxV));
+	maxV = _mm_max_ss(maxV, _mm_shuffle_ps(maxV, maxV, 1));
+	maxValue = _mm_cvtss_f32(maxV);
+#endif
+	for ( ; i < n; ++i) {
+		maxValue = std::max(maxValue, std::abs(buffer[i]));
+	}
+	return maxValue;
+}
+
+// Multiplies the samples by a linear gain ramp, and clips the result to [-1.0, 1.0].
+void
+applyGain(float* buffer, std::size_t n, float gain, float gainStep)
+{
+	std::size_t i = 0;
+#ifdef __SSE__
+	const __m128 maxV = _mm_set1_ps(1.0f);
+	const __m128 minV = _mm_set1_ps(-1.0f);
+	const __m128 stepV = _mm_set1_ps(4.0f * gainStep);
+	__m128 gainV = _mm_setr_ps(gain, gain + gainStep, gain + 2.0f * gainStep, gain + 3.0f * gainStep);
+	for ( ; i + 4 <= n; i += 4) {
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(buffer + i), gainV);
+		_mm_storeu_ps(buffer + i, _mm_max_ps(minV, _mm_min_ps(maxV, x)));
+		gainV = _mm_add_ps(gainV, stepV);
+	}
+#endif
+	for ( ; i < n; ++i) {
+		buffer[i] = std::max(-1.0f, std::min(1.0f, buffer[i] * (gain + i * gainStep)));
+	}
+}
+
+} /* namespace */
+
+namespace GS {
+
+OutputLimiter::OutputLimiter()
+		: attackSamples_{}
+		, releaseSamples_{}
+		, minLevel_{}
+		, envelope_{}
+		, gain_{}
+{
+	reset(1.0f, 0.0f, 0.0f, DEFAULT_MIN_LEVEL);
+}
+
+OutputLimiter::~OutputLimiter()
+{
+}
+
+void
+OutputLimiter::reset(float sampleRate, float attackTime, float releaseTime, float minLevel)
+{
+	attackSamples_ = std::max(0.0f, attackTime * sampleRate);
+	releaseSamples_ = std::max(0.0f, releaseTime * sampleRate);
+	minLevel_ = (minLevel > 0.0f) ? minLevel : DEFAULT_MIN_LEVEL;
+	envelope_ = minLevel_;
+	gain_ = VTM::Util::calculateOutputScale(envelope_);
+}
+
+void
+OutputLimiter::process(float* buffer, std::size_t n)
+{
+	if (n == 0) return;
+
+	const float peak = maximumAbsoluteValue(buffer, n);
+	const float timeSamples = (peak > envelope_) ? attackSamples_ : releaseSamples_;
+	const float coef = (timeSamples > 0.0f) ? 1.0f - std::exp(-static_cast<float>(n) / timeSamples) : 1.0f;
+	envelope_ = std::max(envelope_ + coef * (peak - envelope_), minLevel_);
+
+	// The gain must not exceed the gain for the peak of this block.
+	const float newGain = VTM::Util::calculateOutputScale(std::max(envelope_, peak));
+	if (newGain < gain_) {
+		applyGain(buffer, n, newGain, 0.0f);
+	} else {
+		applyGain(buffer, n, gain_, (newGain - gain_) / n);
+	}
+	gain_ = newGain;
+}
+
+} /* namespace GS */
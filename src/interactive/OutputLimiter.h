@@ -0,0 +1,64 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef OUTPUT_LIMITER_H
+#define OUTPUT_LIMITER_H
+
+#include <cstddef> /* std::size_t */
+
+
+
+namespace GS {
+
+// Normalizes the output level using a peak follower.
+//
+// The peak envelope is updated once per block, rising with the attack time
+// and falling with the release time. The gain of each block is limited by
+// the peak of the block itself, so a rising level (e.g. an onset after a
+// pause) is attenuated immediately. A falling gain is applied to the whole
+// block; a rising gain is ramped across the block. The samples are clipped
+// to [-1.0, 1.0].
+//
+// Levels below minLevel are not amplified more than minLevel, so the gain
+// stays bounded in silences.
+//
+// Only the samples passed to process() are analyzed.
+class OutputLimiter {
+public:
+	OutputLimiter();
+	~OutputLimiter();
+
+	// attackTime, releaseTime: seconds
+	// minLevel: peak level with the maximum gain
+	void reset(float sampleRate, float attackTime, float releaseTime, float minLevel);
+
+	// Called only by the JACK thread.
+	void process(float* buffer, std::size_t n);
+private:
+	OutputLimiter(const OutputLimiter&) = delete;
+	OutputLimiter& operator=(const OutputLimiter&) = delete;
+
+	float attackSamples_;
+	float releaseSamples_;
+	float minLevel_;
+	float envelope_;
+	float gain_;
+};
+
+} /* namespace GS */
+
+#endif // OUTPUT_LIMITER_H
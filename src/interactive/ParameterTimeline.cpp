@@ -0,0 +1,122 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "ParameterTimeline.h"
+
+#include <algorithm> /* find, max, replace, stable_sort */
+#include <fstream>
+#include <sstream>
+
+#include "Exception.h"
+
+
+
+namespace GS {
+
+ParameterTimeline::Player::Player()
+		: timeline_{}
+{
+}
+
+void
+ParameterTimeline::Player::reset(const ParameterTimeline* timeline)
+{
+	timeline_ = timeline;
+	indexList_.assign(timeline_ ? timeline_->numberOfParameters() : 0, 0);
+}
+
+void
+ParameterTimeline::Player::getValues(double time, float* values)
+{
+	if (!timeline_) return;
+
+	for (std::size_t param = 0, numParam = indexList_.size(); param < numParam; ++param) {
+		const std::vector<Point>& points = timeline_->paramPointList_[param];
+		if (points.empty()) continue;
+
+		std::size_t& i = indexList_[param];
+		while (i + 1 < points.size() && points[i + 1].time <= time) {
+			++i;
+		}
+
+		const Point& p1 = points[i];
+		if (time <= p1.time || i + 1 == points.size()) {
+			values[param] = p1.value;
+		} else {
+			const Point& p2 = points[i + 1];
+			values[param] = p1.value + (p2.value - p1.value) * static_cast<float>((time - p1.time) / (p2.time - p1.time));
+		}
+	}
+}
+
+ParameterTimeline::ParameterTimeline(const std::string& filePath,
+					const std::vector<std::string>& paramNameList,
+					const std::vector<float>& paramMinList,
+					const std::vector<float>& paramMaxList)
+		: paramPointList_(paramNameList.size())
+		, duration_{}
+{
+	std::ifstream in(filePath);
+	if (!in) {
+		THROW_EXCEPTION(IOException, "Could not open the file " << filePath << '.');
+	}
+
+	std::vector<std::string> nameList(paramNameList);
+	for (auto& name : nameList) {
+		std::replace(name.begin(), name.end(), ' ', '_');
+	}
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(in, line)) {
+		++lineNumber;
+		std::istringstream lineStream(line);
+		Point point;
+		std::string name;
+		lineStream >> std::ws;
+		if (lineStream.eof() || lineStream.peek() == '#') {
+			continue;
+		}
+		if (!(lineStream >> point.time >> name >> point.value)) {
+			THROW_EXCEPTION(InvalidValueException, "Invalid line " << lineNumber << " in the file " << filePath << '.');
+		}
+		if (point.time < 0.0) {
+			THROW_EXCEPTION(InvalidValueException, "Negative time in line " << lineNumber << " of the file " << filePath << '.');
+		}
+
+		const auto iter = std::find(nameList.begin(), nameList.end(), name);
+		if (iter == nameList.end()) {
+			THROW_EXCEPTION(InvalidValueException, "Unknown parameter in line " << lineNumber << " of the file " << filePath
+					<< ": " << name << '.');
+		}
+		const std::size_t param = iter - nameList.begin();
+		if (point.value < paramMinList[param] || point.value > paramMaxList[param]) {
+			THROW_EXCEPTION(InvalidValueException, "Value out of range in line " << lineNumber << " of the file " << filePath
+					<< ": " << point.value << '.');
+		}
+
+		paramPointList_[param].push_back(point);
+		duration_ = std::max(duration_, point.time);
+	}
+
+	for (auto& pointList : paramPointList_) {
+		std::stable_sort(pointList.begin(), pointList.end(),
+				[](const Point& p1, const Point& p2) { return p1.time < p2.time; });
+	}
+}
+
+} /* namespace GS */
@@ -0,0 +1,81 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef PARAMETER_TIMELINE_H
+#define PARAMETER_TIMELINE_H
+
+#include <cstddef> /* std::size_t */
+#include <string>
+#include <vector>
+
+
+
+namespace GS {
+
+// Time-stamped values of the dynamic parameters.
+//
+// File format (one point per line):
+//
+//     <time (s)> <parameter name> <value>
+//
+// Spaces in the parameter names must be replaced by '_'.
+// Empty lines and lines starting with '#' are ignored.
+//
+// The values between the points are linearly interpolated. Before the first
+// point and after the last point of a parameter, the value is constant.
+class ParameterTimeline {
+public:
+	struct Point {
+		double time;
+		float value;
+	};
+
+	// Gets the values of the parameters at increasing times.
+	class Player {
+	public:
+		Player();
+
+		// Allocates memory.
+		void reset(const ParameterTimeline* timeline);
+
+		// Updates only the parameters that have points in the timeline.
+		// The time must not decrease between calls, until the next reset.
+		// values must point to an array of size timeline.numberOfParameters().
+		void getValues(double time, float* values);
+
+		bool active() const { return timeline_ != nullptr; }
+	private:
+		const ParameterTimeline* timeline_;
+		std::vector<std::size_t> indexList_;
+	};
+
+	ParameterTimeline(const std::string& filePath,
+				const std::vector<std::string>& paramNameList,
+				const std::vector<float>& paramMinList,
+				const std::vector<float>& paramMaxList);
+
+	std::size_t numberOfParameters() const { return paramPointList_.size(); }
+	double duration() const { return duration_; }
+	const std::vector<Point>& pointList(std::size_t parameter) const { return paramPointList_[parameter]; }
+private:
+	std::vector<std::vector<Point>> paramPointList_;
+	double duration_; // seconds
+};
+
+} /* namespace GS */
+
+#endif // PARAMETER_TIMELINE_H
@@ -0,0 +1,80 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "SharedParameterTable.h"
+
+#include "Exception.h"
+
+
+
+namespace GS {
+
+SharedParameterTable::SharedParameterTable(std::size_t numberOfParameters)
+		: numParameters_{numberOfParameters}
+		, numMaskWords_{(numberOfParameters + MASK_WORD_BITS - 1) / MASK_WORD_BITS}
+		, valueList_{std::make_unique<std::atomic<float>[]>(numberOfParameters)}
+		, dirtyMask_{std::make_unique<std::atomic<std::uint64_t>[]>(numMaskWords_)}
+{
+	for (std::size_t i = 0; i < numParameters_; ++i) {
+		valueList_[i].store(0.0f, std::memory_order_relaxed);
+	}
+	for (std::size_t i = 0; i < numMaskWords_; ++i) {
+		dirtyMask_[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void
+SharedParameterTable::set(std::size_t parameter, float value)
+{
+	if (parameter >= numParameters_) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid parameter index: " << parameter << '.');
+	}
+	valueList_[parameter].store(value, std::memory_order_relaxed);
+	// The release makes the value visible before the bit.
+	dirtyMask_[parameter / MASK_WORD_BITS].fetch_or(std::uint64_t{1} << (parameter % MASK_WORD_BITS), std::memory_order_release);
+}
+
+std::size_t
+SharedParameterTable::readChanged(float* values)
+{
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < numMaskWords_; ++i) {
+		std::uint64_t mask = dirtyMask_[i].exchange(0, std::memory_order_acquire);
+		while (mask) {
+			const std::size_t bit = __builtin_ctzll(mask);
+			mask &= mask - 1U;
+			const std::size_t parameter = i * MASK_WORD_BITS + bit;
+			values[parameter] = valueList_[parameter].load(std::memory_order_relaxed);
+			++count;
+		}
+	}
+	return count;
+}
+
+void
+SharedParameterTable::readAll(float* values)
+{
+	for (std::size_t i = 0; i < numMaskWords_; ++i) {
+		dirtyMask_[i].exchange(0, std::memory_order_acquire);
+	}
+	for (std::size_t i = 0; i < numParameters_; ++i) {
+		values[i] = valueList_[i].load(std::memory_order_relaxed);
+	}
+}
+
+} /* namespace GS */
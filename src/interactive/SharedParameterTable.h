@@ -0,0 +1,69 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef SHARED_PARAMETER_TABLE_H
+#define SHARED_PARAMETER_TABLE_H
+
+#include <atomic>
+#include <cstddef> /* std::size_t */
+#include <cstdint>
+#include <memory>
+
+
+
+namespace GS {
+
+// Latest values of a set of parameters, for one writer thread and one
+// reader thread.
+//
+// Each parameter has its own atomic value and a bit in a dirty bitmask.
+// The reader copies only the values that have changed since the last read.
+// A value may be read more than once, but the latest value of each parameter
+// is never lost.
+class SharedParameterTable {
+public:
+	explicit SharedParameterTable(std::size_t numberOfParameters);
+	~SharedParameterTable() = default;
+
+	std::size_t numberOfParameters() const { return numParameters_; }
+
+	// Called only by the writer thread.
+	void set(std::size_t parameter, float value);
+
+	// Called only by the reader thread.
+	// values must point to an array of size numberOfParameters().
+	// Returns the number of values copied.
+	std::size_t readChanged(float* values);
+	void readAll(float* values);
+private:
+	enum {
+		MASK_WORD_BITS = 64
+	};
+
+	SharedParameterTable(const SharedParameterTable&) = delete;
+	SharedParameterTable& operator=(const SharedParameterTable&) = delete;
+
+	const std::size_t numParameters_;
+	const std::size_t numMaskWords_;
+	std::unique_ptr<std::atomic<float>[]> valueList_;
+	std::unique_ptr<std::atomic<std::uint64_t>[]> dirtyMask_;
+};
+
+} /* namespace GS */
+
+#endif // SHARED_PARAMETER_TABLE_H
@@ -26,13 +26,21 @@ SignalDFT::SignalDFT(unsigned int n)
 		, outputN_(n / 2 + 1)
 		, in_(nullptr)
 		, out_(nullptr)
+		, planFlags_(FFTW_ESTIMATE)
 {
-	in_ = FFTW::alloc_real<float>(n_ * sizeof(float));
-	out_ = FFTW::alloc_complex<float>(outputN_ * sizeof(fftwf_complex));
-	{
-		FFTW fftw;
-		dftPlan_ = fftw.plan_dft_r2c_1d(n_, in_, out_, FFTW_ESTIMATE);
-	}
+	FFTW fftw;
+	init(fftw);
+}
+
+// The mutex must be locked by fftw.
+SignalDFT::SignalDFT(unsigned int n, FFTW& fftw)
+		: n_(n)
+		, outputN_(n / 2 + 1)
+		, in_(nullptr)
+		, out_(nullptr)
+		, planFlags_(FFTW_ESTIMATE)
+{
+	init(fftw);
 }
 
 SignalDFT::~SignalDFT()
@@ -45,4 +53,41 @@ SignalDFT::~SignalDFT()
 	FFTW::free(in_);
 }
 
+std::unique_ptr<SignalDFT>
+SignalDFT::tryCreate(unsigned int n)
+{
+	FFTW fftw{std::try_to_lock};
+	if (!fftw.ownsLock()) return nullptr;
+
+	return std::unique_ptr<SignalDFT>(new SignalDFT{n, fftw});
+}
+
+void
+SignalDFT::init(FFTW& fftw)
+{
+	in_ = FFTW::alloc_real<float>(n_);
+	out_ = FFTW::alloc_complex<float>(outputN_);
+	dftPlan_ = fftw.plan_dft_r2c_1d(n_, in_, out_, planFlags_);
+}
+
+bool
+SignalDFT::upgradePlan(unsigned int flags)
+{
+	if (flags == planFlags_) return false;
+
+	FFTW fftw{std::try_to_lock};
+	if (!fftw.ownsLock()) return false;
+	FFTWPlan newPlan;
+	try {
+		// Does not overwrite the buffers.
+		newPlan = fftw.plan_dft_r2c_1d(n_, in_, out_, flags | FFTW_WISDOM_ONLY);
+	} catch (FFTWException&) {
+		return false; // no wisdom
+	}
+	fftw.destroy_plan(dftPlan_);
+	dftPlan_ = newPlan;
+	planFlags_ = flags;
+	return true;
+}
+
 } /* namespace GS */
@@ -19,8 +19,10 @@
 #define SIGNAL_DFT_H
 
 #include <cmath>
+#include <memory>
 
 #include "FFTW.h"
+#include "SpectrumKernels.h"
 
 
 
@@ -32,32 +34,93 @@ public:
 	SignalDFT(unsigned int n);
 	~SignalDFT();
 
+	// Does not wait for other threads that are creating FFTW plans.
+	// Returns null if the FFTW mutex is locked.
+	static std::unique_ptr<SignalDFT> tryCreate(unsigned int n);
+
 	// Returns the absolute value of the spectrum.
 	// input must point to an array of size n (or bigger).
 	// output must point to an array of size n/2 + 1 (or bigger).
 	template<typename T, typename U> void execute(const T* input, U* output);
+	// Pads the input with zeros, if inputSize < n.
+	// input must point to an array of size inputSize.
+	// output must point to an array of size n/2 + 1 (or bigger).
+	template<typename T, typename U> void execute(const T* input, unsigned int inputSize, U* output);
+	// Returns the squared absolute value of the spectrum.
+	// Pads the input with zeros, if inputSize < n.
+	// output must point to an array of size n/2 + 1 (or bigger).
+	template<typename T> void executePower(const T* input, unsigned int inputSize, float* output);
 
 	unsigned int size() const { return n_; }
 	unsigned int outputSize() const { return outputN_; }
+
+	// The DFT is created with FFTW_ESTIMATE. If FFTW has wisdom for the
+	// specified flags (e.g. FFTW_MEASURE), replaces the plan.
+	// Returns true if the plan was replaced.
+	// Does not wait for other threads that are creating FFTW plans, and
+	// returns false in this case.
+	bool upgradePlan(unsigned int flags);
+	unsigned int planFlags() const { return planFlags_; }
 private:
 	SignalDFT(SignalDFT&);
 	SignalDFT& operator=(SignalDFT&);
 
+	SignalDFT(unsigned int n, FFTW& fftw);
+	void init(FFTW& fftw);
+
+	template<typename T> void transform(const T* input, unsigned int inputSize);
+	template<typename U> void copyMagnitude(U* output);
+	void copyMagnitude(float* output) { SpectrumKernels::magnitude(out_, output, outputN_); }
+
 	unsigned int n_;
 	unsigned int outputN_;
 	float* in_;
 	fftwf_complex* out_;
 	FFTWPlan dftPlan_;
+	unsigned int planFlags_;
 };
 
 template<typename T, typename U>
 void
 SignalDFT::execute(const T* input, U* output)
 {
-	for (unsigned int i = 0; i < n_; ++i) {
+	execute(input, n_, output);
+}
+
+template<typename T, typename U>
+void
+SignalDFT::execute(const T* input, unsigned int inputSize, U* output)
+{
+	transform(input, inputSize);
+	copyMagnitude(output);
+}
+
+template<typename T>
+void
+SignalDFT::executePower(const T* input, unsigned int inputSize, float* output)
+{
+	transform(input, inputSize);
+	SpectrumKernels::power(out_, output, outputN_);
+}
+
+template<typename T>
+void
+SignalDFT::transform(const T* input, unsigned int inputSize)
+{
+	if (inputSize > n_) inputSize = n_;
+	for (unsigned int i = 0; i < inputSize; ++i) {
 		in_[i] = input[i];
 	}
+	for (unsigned int i = inputSize; i < n_; ++i) {
+		in_[i] = 0.0f;
+	}
 	FFTW::execute(dftPlan_);
+}
+
+template<typename U>
+void
+SignalDFT::copyMagnitude(U* output)
+{
 	for (unsigned int i = 0; i < outputN_; ++i) {
 		const U rVal = out_[i][FFTW::REAL];
 		const U iVal = out_[i][FFTW::IMAG];
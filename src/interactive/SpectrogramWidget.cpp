@@ -0,0 +1,110 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "SpectrogramWidget.h"
+
+#include <QPainter>
+
+
+
+namespace GS {
+
+SpectrogramWidget::SpectrogramWidget(QWidget* parent)
+		: QWidget{parent}
+		, nextColumn_{}
+		, maxFreq_{}
+		, colorTable_(NUM_COLORS)
+{
+	setBackgroundRole(QPalette::Base);
+	setAutoFillBackground(true);
+
+	// Black -> blue -> red -> yellow -> white.
+	const QColor stops[] = {Qt::black, Qt::blue, Qt::red, Qt::yellow, Qt::white};
+	const int numSegments = sizeof(stops) / sizeof(stops[0]) - 1;
+	for (int i = 0; i < NUM_COLORS; ++i) {
+		const double pos = static_cast<double>(i) * numSegments / NUM_COLORS;
+		const int segment = static_cast<int>(pos);
+		const double k = pos - segment;
+		const QColor& c1 = stops[segment];
+		const QColor& c2 = stops[segment + 1];
+		colorTable_[i] = qRgb(
+					static_cast<int>(c1.red()   + k * (c2.red()   - c1.red())),
+					static_cast<int>(c1.green() + k * (c2.green() - c1.green())),
+					static_cast<int>(c1.blue()  + k * (c2.blue()  - c1.blue())));
+	}
+}
+
+void
+SpectrogramWidget::reset(int numColumns, int numRows, double maxFreq)
+{
+	if (image_.width() != numColumns || image_.height() != numRows) {
+		image_ = QImage(numColumns, numRows, QImage::Format_Indexed8);
+		image_.setColorTable(colorTable_);
+	}
+	image_.fill(0);
+	nextColumn_ = 0;
+	maxFreq_ = maxFreq;
+	update();
+}
+
+void
+SpectrogramWidget::addColumn(const float* values)
+{
+	if (image_.isNull()) return;
+
+	const int numRows = image_.height();
+	for (int i = 0; i < numRows; ++i) {
+		const int colorIndex = qBound(0, static_cast<int>(values[i] * (NUM_COLORS - 1) + 0.5f), NUM_COLORS - 1);
+		// The lowest frequency is at the bottom.
+		image_.scanLine(numRows - 1 - i)[nextColumn_] = static_cast<uchar>(colorIndex);
+	}
+	if (++nextColumn_ == image_.width()) {
+		nextColumn_ = 0;
+	}
+}
+
+void
+SpectrogramWidget::paintEvent(QPaintEvent* /*event*/)
+{
+	if (image_.isNull()) return;
+
+	QPainter painter(this);
+
+	// Draw the ring in two parts: [nextColumn_, width) and [0, nextColumn_).
+	const int numColumns = image_.width();
+	const int numRows = image_.height();
+	const double xScale = static_cast<double>(width()) / numColumns;
+	const int oldWidth = numColumns - nextColumn_;
+	painter.drawImage(QRectF(0.0, 0.0, oldWidth * xScale, height()),
+				image_, QRectF(nextColumn_, 0, oldWidth, numRows));
+	if (nextColumn_ > 0) {
+		painter.drawImage(QRectF(oldWidth * xScale, 0.0, nextColumn_ * xScale, height()),
+					image_, QRectF(0, 0, nextColumn_, numRows));
+	}
+
+	// Frequency labels.
+	painter.setPen(Qt::white);
+	for (int i = 1; i <= NUM_FREQ_LABELS; ++i) {
+		const double freq = maxFreq_ * i / NUM_FREQ_LABELS;
+		const int y = height() - static_cast<int>(static_cast<double>(height()) * i / NUM_FREQ_LABELS);
+		painter.drawLine(0, y, 4, y);
+		painter.drawText(6, y + painter.fontMetrics().ascent(), QString::number(freq, 'f', 0));
+	}
+}
+
+} // namespace GS
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef SPECTROGRAM_WIDGET_H
+#define SPECTROGRAM_WIDGET_H
+
+#include <QImage>
+#include <QVector>
+#include <QWidget>
+
+
+
+namespace GS {
+
+// Scrolling spectrogram.
+//
+// The columns are stored in a ring, so adding a column only writes the new
+// pixels. The oldest column is shown at the left.
+class SpectrogramWidget : public QWidget {
+	Q_OBJECT
+public:
+	explicit SpectrogramWidget(QWidget* parent=nullptr);
+
+	// Clears the image.
+	void reset(int numColumns, int numRows, double maxFreq);
+	int numRows() const { return image_.height(); }
+	// values: numRows() values in the range [0.0, 1.0], from the lowest to
+	// the highest frequency.
+	// update() must be called after the columns have been added.
+	void addColumn(const float* values);
+protected:
+	virtual void paintEvent(QPaintEvent* event);
+private:
+	enum {
+		NUM_COLORS = 256,
+		NUM_FREQ_LABELS = 4
+	};
+
+	QImage image_;
+	int nextColumn_;
+	double maxFreq_;
+	QVector<QRgb> colorTable_;
+};
+
+} // namespace GS
+
+#endif // SPECTROGRAM_WIDGET_H
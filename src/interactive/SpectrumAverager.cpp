@@ -0,0 +1,207 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "SpectrumAverager.h"
+
+#include <algorithm> /* copy, fill */
+#include <chrono>
+#include <cmath> /* exp */
+#include <cstring> /* memmove */
+#include <iostream>
+
+#include "SignalDFT.h"
+#include "SpectrumKernels.h"
+
+
+
+namespace GS {
+
+SpectrumAverager::SpectrumAverager(std::size_t inputQueueSize)
+		: inputQueue_{inputQueueSize}
+		, stop_{}
+		, newSettings_{}
+		, settingsChanged_{}
+		, planFlags_{FFTW_ESTIMATE}
+		, settings_{}
+		, frameBufferCount_{}
+		, emaCoef_{}
+		, numFrames_{}
+		, firstFrame_{true}
+{
+	thread_ = std::thread(&SpectrumAverager::run, this);
+}
+
+SpectrumAverager::~SpectrumAverager()
+{
+	{
+		std::lock_guard<std::mutex> lock(inputMutex_);
+		stop_ = true;
+	}
+	inputCondition_.notify_one();
+	thread_.join();
+}
+
+void
+SpectrumAverager::setSettings(const Settings& settings)
+{
+	std::lock_guard<std::mutex> lock(settingsMutex_);
+	if (settings == newSettings_) {
+		return;
+	}
+	newSettings_ = settings;
+	settingsChanged_ = true;
+}
+
+void
+SpectrumAverager::restart()
+{
+	std::lock_guard<std::mutex> lock(settingsMutex_);
+	settingsChanged_ = true;
+}
+
+void
+SpectrumAverager::push(const float* samples, std::size_t n)
+{
+	if (n == 0) {
+		return;
+	}
+	inputQueue_.push(samples, n);
+	{
+		// Avoids a lost wakeup between the test and the wait in run().
+		std::lock_guard<std::mutex> lock(inputMutex_);
+	}
+	inputCondition_.notify_one();
+}
+
+bool
+SpectrumAverager::getResult(std::vector<float>& power)
+{
+	std::lock_guard<std::mutex> lock(resultMutex_);
+	if (numFrames_ == 0) {
+		return false;
+	}
+
+	power.assign(result_.begin(), result_.end());
+	if (settings_.mode == Mode::welch) {
+		SpectrumKernels::scale(&power[0], power.size(), 1.0f / numFrames_);
+		std::fill(result_.begin(), result_.end(), 0.0f);
+	}
+	numFrames_ = 0;
+	return true;
+}
+
+void
+SpectrumAverager::run()
+{
+	try {
+		while (!stop_) {
+			{
+				std::unique_lock<std::mutex> lock(inputMutex_);
+				inputCondition_.wait_for(lock, std::chrono::milliseconds(WAIT_TIMEOUT_MS),
+						[&]() { return stop_ || inputQueue_.readAvailable() > 0; });
+			}
+			if (stop_) break;
+
+			applySettings();
+			if (!dft_) {
+				inputQueue_.skip(inputQueue_.readAvailable());
+				continue;
+			}
+			dft_->upgradePlan(planFlags_);
+
+			// Process all the available samples.
+			const std::size_t windowSize = settings_.window.size();
+			for (;;) {
+				frameBufferCount_ += inputQueue_.pop(&frameBuffer_[frameBufferCount_], windowSize - frameBufferCount_);
+				if (frameBufferCount_ < windowSize) break;
+
+				processFrame();
+
+				std::memmove(&frameBuffer_[0], &frameBuffer_[settings_.hopSize], (windowSize - settings_.hopSize) * sizeof(float));
+				frameBufferCount_ -= settings_.hopSize;
+			}
+		}
+	} catch (std::exception& exc) {
+		std::cerr << "[SpectrumAverager::run] Caught exception: " << exc.what() << '.' << std::endl;
+	}
+}
+
+void
+SpectrumAverager::applySettings()
+{
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex_);
+		if (!settingsChanged_) {
+			return;
+		}
+		settingsChanged_ = false;
+
+		std::lock_guard<std::mutex> resultLock(resultMutex_);
+		settings_ = newSettings_;
+		result_.assign(settings_.dftSize / 2 + 1, 0.0f);
+		numFrames_ = 0;
+		firstFrame_ = true;
+	}
+
+	const std::size_t windowSize = settings_.window.size();
+	if (windowSize == 0 || settings_.hopSize == 0 || settings_.hopSize > windowSize || settings_.dftSize < windowSize) {
+		dft_.reset();
+		return;
+	}
+	if (!dft_ || dft_->size() != settings_.dftSize) {
+		dft_ = std::make_unique<SignalDFT>(settings_.dftSize);
+	}
+	frameBuffer_.assign(windowSize, 0.0f);
+	frameBufferCount_ = 0;
+	frame_.resize(windowSize);
+	framePower_.resize(dft_->outputSize());
+	emaCoef_ = 1.0 - std::exp(-static_cast<double>(settings_.hopSize) / (settings_.timeConstant * settings_.sampleRate));
+}
+
+void
+SpectrumAverager::processFrame()
+{
+	const std::size_t windowSize = settings_.window.size();
+	std::copy(frameBuffer_.begin(), frameBuffer_.end(), frame_.begin());
+	SpectrumKernels::multiply(&frame_[0], &settings_.window[0], windowSize);
+	dft_->executePower(&frame_[0], windowSize, &framePower_[0]); // zero padding
+
+	std::lock_guard<std::mutex> lock(resultMutex_);
+	const std::size_t n = framePower_.size();
+	switch (settings_.mode) {
+	case Mode::welch:
+		SpectrumKernels::add(&result_[0], &framePower_[0], n);
+		break;
+	case Mode::exponential:
+		if (firstFrame_) {
+			std::copy(framePower_.begin(), framePower_.end(), result_.begin());
+		} else {
+			for (std::size_t i = 0; i < n; ++i) {
+				result_[i] += emaCoef_ * (framePower_[i] - result_[i]);
+			}
+		}
+		break;
+	case Mode::peakHold:
+		SpectrumKernels::maximum(&result_[0], &framePower_[0], n);
+		break;
+	}
+	firstFrame_ = false;
+	++numFrames_;
+}
+
+} /* namespace GS */
@@ -0,0 +1,122 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef SPECTRUM_AVERAGER_H
+#define SPECTRUM_AVERAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef> /* std::size_t */
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SPSCQueue.h"
+
+
+
+namespace GS {
+
+class SignalDFT;
+
+// Computes averaged power spectra in a worker thread, using all the samples
+// received.
+//
+// The input is divided in overlapping frames. Each frame is windowed and
+// transformed, and its power spectrum is combined with the previous ones
+// according to the mode.
+class SpectrumAverager {
+public:
+	enum class Mode {
+		welch,       // mean of the frames received since the last result
+		exponential, // exponential moving average
+		peakHold     // maximum since the last change of settings
+	};
+	struct Settings {
+		Mode mode;
+		unsigned int dftSize; // power of two, >= window.size()
+		unsigned int hopSize;
+		double sampleRate;
+		double timeConstant; // exponential mode (seconds)
+		std::vector<float> window;
+
+		bool operator==(const Settings& o) const {
+			return mode == o.mode && dftSize == o.dftSize && hopSize == o.hopSize &&
+				sampleRate == o.sampleRate && timeConstant == o.timeConstant && window == o.window;
+		}
+	};
+
+	// The thread starts in the constructor.
+	explicit SpectrumAverager(std::size_t inputQueueSize);
+	~SpectrumAverager();
+
+	// Restarts the averaging if the settings have changed.
+	void setSettings(const Settings& settings);
+	// The DFT plan is upgraded when FFTW has wisdom for the flags
+	// (see SignalDFT::upgradePlan()). Does not restart the averaging.
+	void setPlanFlags(unsigned int flags) { planFlags_ = flags; }
+	// Discards the accumulated spectrum and the buffered samples.
+	void restart();
+	// Called by the producer thread. The samples that don't fit in the queue
+	// are discarded.
+	void push(const float* samples, std::size_t n);
+	// Copies the power spectrum (size: dftSize / 2 + 1).
+	// Returns false if there is no new data since the last call.
+	bool getResult(std::vector<float>& power);
+private:
+	enum {
+		WAIT_TIMEOUT_MS = 20
+	};
+
+	SpectrumAverager(const SpectrumAverager&) = delete;
+	SpectrumAverager& operator=(const SpectrumAverager&) = delete;
+
+	void run();
+	void applySettings();
+	void processFrame();
+
+	SPSCQueue<float> inputQueue_;
+	std::thread thread_;
+	std::atomic<bool> stop_;
+	std::mutex inputMutex_; // for the condition variable
+	std::condition_variable inputCondition_;
+
+	std::mutex settingsMutex_;
+	Settings newSettings_;
+	bool settingsChanged_;
+	std::atomic<unsigned int> planFlags_;
+
+	// Used only by the worker thread.
+	Settings settings_;
+	std::unique_ptr<SignalDFT> dft_;
+	std::vector<float> frameBuffer_;
+	std::size_t frameBufferCount_;
+	std::vector<float> frame_;
+	std::vector<float> framePower_;
+	float emaCoef_;
+
+	std::mutex resultMutex_;
+	std::vector<float> result_;
+	unsigned int numFrames_; // since the last result
+	bool firstFrame_;
+};
+
+} /* namespace GS */
+
+#endif // SPECTRUM_AVERAGER_H
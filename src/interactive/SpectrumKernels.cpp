@@ -0,0 +1,273 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "SpectrumKernels.h"
+
+#include <algorithm> /* max, min */
+#include <cfloat> /* FLT_MIN */
+#include <cmath> /* abs, sqrt */
+#include <cstdint>
+#include <cstring> /* memcpy */
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+// 10 * log10(2)
+#define DB_PER_OCTAVE (3.01029995664f)
+
+// Coefficients of the polynomial approximation of log2(1 + t), 0 <= t < 1.
+#define LOG2_C0 (0.000114579960f)
+#define LOG2_C1 (1.43687489622f)
+#define LOG2_C2 (-0.670882679015f)
+#define LOG2_C3 (0.312269477327f)
+#define LOG2_C4 (-0.0784406762091f)
+
+
+
+namespace {
+
+// x must be positive and normalized.
+inline
+float
+fastLog2(float x)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &x, sizeof bits);
+	const float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+	bits = (bits & 0x007FFFFFU) | 0x3F800000U;
+	float m;
+	std::memcpy(&m, &bits, sizeof m);
+	const float t = m - 1.0f;
+	return exponent + LOG2_C0 + t * (LOG2_C1 + t * (LOG2_C2 + t * (LOG2_C3 + t * LOG2_C4)));
+}
+
+} /* namespace */
+
+namespace GS {
+namespace SpectrumKernels {
+
+void
+magnitude(const fftwf_complex* in, float* out, std::size_t n)
+{
+	const float* src = &in[0][0];
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		const __m128 a = _mm_loadu_ps(src + 2 * i);     // r0 i0 r1 i1
+		const __m128 b = _mm_loadu_ps(src + 2 * i + 4); // r2 i2 r3 i3
+		const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		const float re = src[2 * i];
+		const float im = src[2 * i + 1];
+		out[i] = std::sqrt(re * re + im * im);
+	}
+}
+
+void
+power(const fftwf_complex* in, float* out, std::size_t n)
+{
+	const float* src = &in[0][0];
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		const __m128 a = _mm_loadu_ps(src + 2 * i);
+		const __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+		const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		const float re = src[2 * i];
+		const float im = src[2 * i + 1];
+		out[i] = re * re + im * im;
+	}
+}
+
+void
+powerToDecibel(const float* in, float* out, std::size_t n, float coef)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	const __m128 coefV = _mm_set1_ps(coef);
+	const __m128 minV = _mm_set1_ps(FLT_MIN);
+	const __m128i mantissaMask = _mm_set1_epi32(0x007FFFFF);
+	const __m128i one = _mm_set1_epi32(0x3F800000);
+	const __m128i bias = _mm_set1_epi32(127);
+	const __m128 oneF = _mm_set1_ps(1.0f);
+	const __m128 c0 = _mm_set1_ps(LOG2_C0);
+	const __m128 c1 = _mm_set1_ps(LOG2_C1);
+	const __m128 c2 = _mm_set1_ps(LOG2_C2);
+	const __m128 c3 = _mm_set1_ps(LOG2_C3);
+	const __m128 c4 = _mm_set1_ps(LOG2_C4);
+	const __m128 dbCoef = _mm_set1_ps(DB_PER_OCTAVE);
+	for ( ; i + 4 <= n; i += 4) {
+		const __m128 x = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), coefV), minV);
+		const __m128i bits = _mm_castps_si128(x);
+		const __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+		const __m128 t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), one)), oneF);
+		__m128 p = _mm_add_ps(c3, _mm_mul_ps(t, c4));
+		p = _mm_add_ps(c2, _mm_mul_ps(t, p));
+		p = _mm_add_ps(c1, _mm_mul_ps(t, p));
+		p = _mm_add_ps(c0, _mm_mul_ps(t, p));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(exponent, p), dbCoef));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		out[i] = DB_PER_OCTAVE * fastLog2(std::max(in[i] * coef, FLT_MIN));
+	}
+}
+
+void
+scale(float* data, std::size_t n, float coef)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	const __m128 coefV = _mm_set1_ps(coef);
+	for ( ; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), coefV));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		data[i] *= coef;
+	}
+}
+
+void
+multiply(float* data, const float* coef, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(coef + i)));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		data[i] *= coef[i];
+	}
+}
+
+void
+add(float* data, const float* x, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(data + i, _mm_add_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(x + i)));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		data[i] += x[i];
+	}
+}
+
+void
+maximum(float* data, const float* x, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(data + i, _mm_max_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(x + i)));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		data[i] = std::max(data[i], x[i]);
+	}
+}
+
+void
+squareRoot(float* data, std::size_t n)
+{
+	std::size_t i = 0;
+#ifdef __SSE2__
+	for ( ; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(data + i, _mm_sqrt_ps(_mm_loadu_ps(data + i)));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		data[i] = std::sqrt(data[i]);
+	}
+}
+
+float
+maxAbs(const float* data, std::size_t n)
+{
+	float maxValue = 0.0f;
+	std::size_t i = 0;
+#ifdef __SSE2__
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 maxV = _mm_setzero_ps();
+	for ( ; i + 4 <= n; i += 4) {
+		maxV = _mm_max_ps(maxV, _mm_and_ps(_mm_loadu_ps(data + i), absMask));
+	}
+	float v[4];
+	_mm_storeu_ps(v, maxV);
+	maxValue = std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+#endif
+	for ( ; i < n; ++i) {
+		maxValue = std::max(maxValue, std::abs(data[i]));
+	}
+	return maxValue;
+}
+
+void
+normalize(float* data, std::size_t n)
+{
+	const float maxValue = maxAbs(data, n);
+	if (maxValue > 0.0f) {
+		scale(data, n, 1.0f / maxValue);
+	}
+}
+
+void
+minMax(const float* data, std::size_t n, float& minValue, float& maxValue)
+{
+	float minV = data[0];
+	float maxV = data[0];
+	std::size_t i = 0;
+#ifdef __SSE2__
+	if (n >= 4) {
+		__m128 minVec = _mm_loadu_ps(data);
+		__m128 maxVec = minVec;
+		for (i = 4; i + 4 <= n; i += 4) {
+			const __m128 x = _mm_loadu_ps(data + i);
+			minVec = _mm_min_ps(minVec, x);
+			maxVec = _mm_max_ps(maxVec, x);
+		}
+		float v1[4], v2[4];
+		_mm_storeu_ps(v1, minVec);
+		_mm_storeu_ps(v2, maxVec);
+		minV = std::min(std::min(v1[0], v1[1]), std::min(v1[2], v1[3]));
+		maxV = std::max(std::max(v2[0], v2[1]), std::max(v2[2], v2[3]));
+	}
+#endif
+	for ( ; i < n; ++i) {
+		minV = std::min(minV, data[i]);
+		maxV = std::max(maxV, data[i]);
+	}
+	minValue = minV;
+	maxValue = maxV;
+}
+
+} /* namespace SpectrumKernels */
+} /* namespace GS */
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#ifndef SPECTRUM_KERNELS_H
+#define SPECTRUM_KERNELS_H
+
+#include <cstddef> /* std::size_t */
+
+#include "fftw3.h"
+
+
+
+namespace GS {
+namespace SpectrumKernels {
+
+// Float kernels for the spectrum display.
+// They use SSE2 when available. The arrays don't need to be aligned.
+
+// out[i] = |in[i]|
+void magnitude(const fftwf_complex* in, float* out, std::size_t n);
+// out[i] = |in[i]|^2
+void power(const fftwf_complex* in, float* out, std::size_t n);
+// out[i] = 10 * log10(in[i] * coef)
+// Uses an approximation of log2 (max. error: 0.0004 dB).
+// The results are limited to about -380 dB. in and out may be the same array.
+void powerToDecibel(const float* in, float* out, std::size_t n, float coef);
+// data[i] *= coef
+void scale(float* data, std::size_t n, float coef);
+// data[i] *= coef[i]
+void multiply(float* data, const float* coef, std::size_t n);
+// data[i] += x[i]
+void add(float* data, const float* x, std::size_t n);
+// data[i] = max(data[i], x[i])
+void maximum(float* data, const float* x, std::size_t n);
+// data[i] = sqrt(data[i])
+void squareRoot(float* data, std::size_t n);
+// Returns max(|data[i]|).
+float maxAbs(const float* data, std::size_t n);
+// Scales the data to the range [-1.0, 1.0].
+void normalize(float* data, std::size_t n);
+// n must be > 0.
+void minMax(const float* data, std::size_t n, float& minValue, float& maxValue);
+
+} /* namespace SpectrumKernels */
+} /* namespace GS */
+
+#endif // SPECTRUM_KERNELS_H
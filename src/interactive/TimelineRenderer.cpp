@@ -0,0 +1,92 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "TimelineRenderer.h"
+
+#include <chrono>
+#include <cmath> /* ceil */
+#include <memory>
+
+#include "ConfigurationData.h"
+#include "Exception.h"
+#include "ParameterTimeline.h"
+#include "VocalTractModel.h"
+#include "VTMUtil.h"
+#include "WAVEFileWriter.h"
+
+
+
+namespace GS {
+namespace TimelineRenderer {
+
+Result
+render(const ParameterTimeline& timeline, const ConfigurationData& vtmData,
+		const std::vector<float>& paramValues, std::vector<float>& output)
+{
+	if (paramValues.size() != timeline.numberOfParameters()) {
+		THROW_EXCEPTION(InvalidValueException, "Wrong number of parameters: " << paramValues.size()
+				<< " (should be " << timeline.numberOfParameters() << ").");
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+
+	std::unique_ptr<VTM::VocalTractModel> vtm = VTM::VocalTractModel::getInstance(vtmData, true);
+	const double internalRate = vtm->internalSampleRate();
+	const unsigned long numSteps = static_cast<unsigned long>(std::ceil(timeline.duration() * internalRate)) + 1U;
+
+	ParameterTimeline::Player player;
+	player.reset(&timeline);
+	std::vector<float> values(paramValues);
+
+	std::vector<float>& vtmOutputBuffer = vtm->outputBuffer();
+	output.clear();
+	output.reserve(static_cast<std::size_t>(timeline.duration() * vtm->outputSampleRate()) + 1U);
+	for (unsigned long step = 0; step < numSteps; ++step) {
+		player.getValues(step / internalRate, values.data());
+		vtm->setAllParameters(values);
+		vtm->execSynthesisStep();
+		if (!vtmOutputBuffer.empty()) {
+			output.insert(output.end(), vtmOutputBuffer.begin(), vtmOutputBuffer.end());
+			vtmOutputBuffer.clear();
+		}
+	}
+	vtm->finishSynthesis();
+	output.insert(output.end(), vtmOutputBuffer.begin(), vtmOutputBuffer.end());
+	vtmOutputBuffer.clear();
+
+	const auto t1 = std::chrono::steady_clock::now();
+
+	Result result;
+	result.outputSampleRate = vtm->outputSampleRate();
+	result.audioDuration = output.size() / result.outputSampleRate;
+	result.renderTime = std::chrono::duration<double>(t1 - t0).count();
+	return result;
+}
+
+void
+writeWAVFile(const std::vector<float>& signal, unsigned int sampleRate, const std::string& filePath)
+{
+	// Same output as the synthesis to file.
+	const float scale = VTM::Util::calculateOutputScale(VTM::Util::maximumAbsoluteValue(signal));
+	WAVEFileWriter fileWriter(filePath.c_str(), 1, signal.size(), sampleRate);
+	for (float sample : signal) {
+		fileWriter.writeSample(sample * scale);
+	}
+}
+
+} /* namespace TimelineRenderer */
+} /* namespace GS */
@@ -1,5 +1,5 @@
 /***************************************************************************
- *  Copyright 2016 Marcelo Y. Matuda                                       *
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
  *                                                                         *
  *  This program is free software: you can redistribute it and/or modify   *
  *  it under the terms of the GNU General Public License as published by   *
@@ -15,42 +15,38 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
  ***************************************************************************/
 
-#ifndef JACK_RINGBUFFER_H
-#define JACK_RINGBUFFER_H
+#ifndef TIMELINE_RENDERER_H
+#define TIMELINE_RENDERER_H
 
-#include <jack/ringbuffer.h>
+#include <string>
+#include <vector>
 
 
 
 namespace GS {
 
-class JackRingbuffer {
-public:
-	JackRingbuffer(size_t ringbufferSize);
-	~JackRingbuffer();
+class ConfigurationData;
+class ParameterTimeline;
 
-	size_t readSpace();
-	size_t writeSpace();
+// Renders a parameter timeline without JACK, as fast as possible.
+namespace TimelineRenderer {
 
-	// Returns the number of bytes read.
-	size_t read(char* dest, size_t cnt);
-
-	// Returns the number of bytes written.
-	size_t write(const char* src, size_t cnt);
-
-	// Returns the number of bytes read.
-	size_t peek(char* dest, size_t cnt);
-
-	void advanceRead(size_t cnt);
+struct Result {
+	double outputSampleRate;
+	double audioDuration; // seconds
+	double renderTime;    // seconds
+};
 
-	void reset(); // not thread safe
-private:
-	JackRingbuffer(JackRingbuffer&);
-	JackRingbuffer& operator=(JackRingbuffer&);
+// paramValues: values of the parameters that have no points in the timeline.
+// The output is not normalized.
+Result render(const ParameterTimeline& timeline, const ConfigurationData& vtmData,
+		const std::vector<float>& paramValues, std::vector<float>& output);
 
-	jack_ringbuffer_t* ringbuffer_;
-};
+// Normalizes the signal and saves it as a mono WAV file, using the
+// same writer as the synthesis to file.
+void writeWAVFile(const std::vector<float>& signal, unsigned int sampleRate, const std::string& filePath);
 
+} /* namespace TimelineRenderer */
 } /* namespace GS */
 
-#endif // JACK_RINGBUFFER_H
+#endif // TIMELINE_RENDERER_H
@@ -0,0 +1,459 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include "VTMBenchmark.h"
+
+#include <algorithm> /* max, min, sort */
+#include <atomic>
+#include <chrono>
+#include <cmath> /* sin */
+#include <cstdlib> /* EXIT_SUCCESS */
+#include <cstring> /* strcmp */
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept> /* logic_error */
+#include <string>
+#include <thread>
+#include <utility> /* move */
+#include <vector>
+
+#include "ConfigurationData.h"
+#include "Exception.h"
+#include "InteractiveVTMConfiguration.h"
+#include "ParameterTimeline.h"
+#include "VocalTractModel.h"
+#include "VocalTractModelPool.h"
+#include "VTMUtil.h"
+
+#define DEFAULT_DURATION_SEC (10.0)
+#define DEFAULT_OUTPUT_RATE (44100.0f)
+#define MAX_THREADS 256U
+// Built-in workload: each dynamic parameter oscillates around its default
+// value, with a different frequency.
+#define SWEEP_BASE_FREQUENCY (0.5)
+#define SWEEP_FREQUENCY_STEP (0.25)
+#define SWEEP_AMPLITUDE_RATIO (0.25) // relative to the parameter range
+#define OUTPUT_BLOCK_SIZE 256
+#define START_LATENCY_REPETITIONS 5
+
+
+
+namespace {
+
+using namespace GS;
+
+const double PI = 3.14159265358979323846;
+
+struct Options {
+	std::string configDirPath;
+	unsigned int maxThreads;
+	double duration;
+	float outputRate;
+	std::string timelineFilePath;
+	std::string jsonFilePath;
+};
+
+struct ThreadResult {
+	double outputRate; // of the vocal tract model
+	unsigned long long outputSamples;
+	double renderTime; // s
+	std::vector<float> stepLatencyList; // us
+};
+
+struct RunResult {
+	unsigned int numThreads;
+	double wallTime; // s
+	double samplesPerSecond;
+	double realTimeFactor; // mean of (audio duration / render time) of the threads
+	double realtimeVoices; // total audio duration / wall time
+	double scalingEfficiency;
+	double latencyP50; // us
+	double latencyP90;
+	double latencyP99;
+	double latencyMax;
+};
+
+// Time to get a vocal tract model ready when the audio is started (us).
+struct StartLatency {
+	double newInstance; // created when needed
+	double pool;        // taken from a prepared pool
+};
+
+// Parameter trajectory, used by one thread.
+class Trajectory {
+public:
+	Trajectory(const InteractiveVTMConfiguration& configuration, const ParameterTimeline* timeline)
+			: configuration_{configuration}
+			, timeline_{timeline}
+			, timelineStart_{}
+	{
+		player_.reset(timeline_);
+	}
+
+	// The time must not decrease between calls.
+	void getValues(double time, float* values);
+private:
+	const InteractiveVTMConfiguration& configuration_;
+	const ParameterTimeline* timeline_;
+	ParameterTimeline::Player player_;
+	double timelineStart_;
+};
+
+void
+Trajectory::getValues(double time, float* values)
+{
+	if (timeline_) {
+		// The timeline is repeated.
+		if (timeline_->duration() > 0.0 && time - timelineStart_ > timeline_->duration()) {
+			timelineStart_ = time;
+			player_.reset(timeline_);
+		}
+		player_.getValues(time - timelineStart_, values);
+		return;
+	}
+
+	for (std::size_t i = 0, size = configuration_.dynamicParamList.size(); i < size; ++i) {
+		const float minValue = configuration_.dynamicParamMinList[i];
+		const float maxValue = configuration_.dynamicParamMaxList[i];
+		const double freq = SWEEP_BASE_FREQUENCY + SWEEP_FREQUENCY_STEP * i;
+		const float value = configuration_.dynamicParamList[i] +
+					SWEEP_AMPLITUDE_RATIO * (maxValue - minValue) * std::sin(2.0 * PI * freq * time);
+		values[i] = std::min(std::max(value, minValue), maxValue);
+	}
+}
+
+Options
+parseOptions(int argc, char* argv[])
+{
+	if (argc < 1) {
+		THROW_EXCEPTION(InvalidParameterException, "Missing configuration directory.");
+	}
+
+	Options options;
+	options.configDirPath = argv[0];
+	options.maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+	options.duration = DEFAULT_DURATION_SEC;
+	options.outputRate = DEFAULT_OUTPUT_RATE;
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 >= argc) {
+			THROW_EXCEPTION(InvalidParameterException, "Missing value for the option " << argv[i] << '.');
+		}
+		const char* option = argv[i];
+		const std::string value = argv[++i];
+		try {
+			if (std::strcmp(option, "--threads") == 0) {
+				options.maxThreads = std::stoul(value);
+			} else if (std::strcmp(option, "--duration") == 0) {
+				options.duration = std::stod(value);
+			} else if (std::strcmp(option, "--output-rate") == 0) {
+				options.outputRate = std::stof(value);
+			} else if (std::strcmp(option, "--timeline") == 0) {
+				options.timelineFilePath = value;
+			} else if (std::strcmp(option, "--json") == 0) {
+				options.jsonFilePath = value;
+			} else {
+				THROW_EXCEPTION(InvalidParameterException, "Invalid option: " << option << '.');
+			}
+		} catch (std::logic_error&) { // from stoul, stod, stof
+			THROW_EXCEPTION(InvalidValueException, "Invalid value for the option " << option << ": " << value << '.');
+		}
+	}
+
+	if (options.maxThreads < 1 || options.maxThreads > MAX_THREADS) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid number of threads: " << options.maxThreads << '.');
+	}
+	if (options.duration <= 0.0) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid duration: " << options.duration << '.');
+	}
+	if (options.outputRate <= 0.0f) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid output rate: " << options.outputRate << '.');
+	}
+	return options;
+}
+
+void
+renderThread(const InteractiveVTMConfiguration& configuration, const ConfigurationData& vtmData,
+		const ParameterTimeline* timeline, double duration,
+		std::atomic<unsigned int>& readyCount, const std::atomic<bool>& start,
+		ThreadResult& result)
+{
+	std::unique_ptr<VTM::VocalTractModel> vtm = VTM::VocalTractModel::getInstance(vtmData, true);
+	const double internalRate = vtm->internalSampleRate();
+	result.outputRate = vtm->outputSampleRate();
+	const unsigned long long targetSamples = static_cast<unsigned long long>(duration * result.outputRate);
+
+	Trajectory trajectory{configuration, timeline};
+	std::vector<float> paramValues(configuration.dynamicParamList);
+	std::vector<float> block(OUTPUT_BLOCK_SIZE);
+	std::vector<float>& vtmOutputBuffer = vtm->outputBuffer();
+	std::size_t vtmBufferPos = 0;
+
+	result.outputSamples = 0;
+	result.stepLatencyList.clear();
+	result.stepLatencyList.reserve(static_cast<std::size_t>(duration * internalRate) + 1U);
+
+	++readyCount;
+	while (!start) {
+		std::this_thread::yield();
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+	for (unsigned long step = 0; result.outputSamples < targetSamples; ++step) {
+		trajectory.getValues(step / internalRate, paramValues.data());
+
+		const auto stepT0 = std::chrono::steady_clock::now();
+		vtm->setAllParameters(paramValues);
+		vtm->execSynthesisStep();
+		const auto stepT1 = std::chrono::steady_clock::now();
+		result.stepLatencyList.push_back(std::chrono::duration<float, std::micro>(stepT1 - stepT0).count());
+
+		while (!vtmOutputBuffer.empty()) {
+			result.outputSamples += VTM::Util::getSamples(vtmOutputBuffer, vtmBufferPos, block.data(), block.size(), 1.0f);
+		}
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	result.renderTime = std::chrono::duration<double>(t1 - t0).count();
+}
+
+double
+percentile(const std::vector<float>& sortedList, double p)
+{
+	if (sortedList.empty()) return 0.0;
+	const std::size_t index = static_cast<std::size_t>(p * (sortedList.size() - 1U) + 0.5);
+	return sortedList[std::min(index, sortedList.size() - 1U)];
+}
+
+RunResult
+runThreads(unsigned int numThreads, const InteractiveVTMConfiguration& configuration, const ConfigurationData& vtmData,
+		const ParameterTimeline* timeline, double duration)
+{
+	std::vector<ThreadResult> threadResultList(numThreads);
+	std::vector<std::thread> threadList;
+	std::vector<std::exception_ptr> exceptionList(numThreads);
+	std::atomic<unsigned int> readyCount{0};
+	std::atomic<bool> start{false};
+
+	for (unsigned int i = 0; i < numThreads; ++i) {
+		threadList.emplace_back([&, i]() {
+			try {
+				renderThread(configuration, vtmData, timeline, duration, readyCount, start, threadResultList[i]);
+			} catch (...) {
+				exceptionList[i] = std::current_exception();
+				++readyCount;
+			}
+		});
+	}
+	while (readyCount < numThreads) {
+		std::this_thread::yield();
+	}
+	const auto t0 = std::chrono::steady_clock::now();
+	start = true;
+	for (auto& thread : threadList) {
+		thread.join();
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	for (auto& exc : exceptionList) {
+		if (exc) std::rethrow_exception(exc);
+	}
+
+	RunResult result;
+	result.numThreads = numThreads;
+	result.wallTime = std::chrono::duration<double>(t1 - t0).count();
+
+	unsigned long long totalSamples = 0;
+	double totalDuration = 0.0; // s
+	double rtfSum = 0.0;
+	std::vector<float> latencyList;
+	for (const ThreadResult& tr : threadResultList) {
+		totalSamples += tr.outputSamples;
+		totalDuration += tr.outputSamples / tr.outputRate;
+		rtfSum += (tr.outputSamples / tr.outputRate) / tr.renderTime;
+		latencyList.insert(latencyList.end(), tr.stepLatencyList.begin(), tr.stepLatencyList.end());
+	}
+	std::sort(latencyList.begin(), latencyList.end());
+
+	result.samplesPerSecond = totalSamples / result.wallTime;
+	result.realTimeFactor = rtfSum / numThreads;
+	result.realtimeVoices = totalDuration / result.wallTime;
+	result.scalingEfficiency = 1.0; // calculated later
+	result.latencyP50 = percentile(latencyList, 0.50);
+	result.latencyP90 = percentile(latencyList, 0.90);
+	result.latencyP99 = percentile(latencyList, 0.99);
+	result.latencyMax = latencyList.empty() ? 0.0 : latencyList.back();
+	return result;
+}
+
+// Returns the median of the repetitions.
+StartLatency
+measureStartLatency(const std::string& key, const ConfigurationData& vtmData)
+{
+	std::vector<double> newInstanceList;
+	std::vector<double> poolList;
+	VocalTractModelPool pool{true, 1, 1};
+	for (unsigned int i = 0; i < START_LATENCY_REPETITIONS; ++i) {
+		{
+			const auto t0 = std::chrono::steady_clock::now();
+			std::unique_ptr<VTM::VocalTractModel> vtm = VTM::VocalTractModel::getInstance(vtmData, true);
+			const auto t1 = std::chrono::steady_clock::now();
+			newInstanceList.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+		}
+
+		pool.prepare(key, vtmData, 1);
+		const auto t0 = std::chrono::steady_clock::now();
+		std::unique_ptr<VTM::VocalTractModel> vtm = pool.acquire(key, vtmData);
+		const auto t1 = std::chrono::steady_clock::now();
+		poolList.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+		pool.release(key, std::move(vtm));
+	}
+	std::sort(newInstanceList.begin(), newInstanceList.end());
+	std::sort(poolList.begin(), poolList.end());
+
+	StartLatency latency;
+	latency.newInstance = newInstanceList[newInstanceList.size() / 2U];
+	latency.pool = poolList[poolList.size() / 2U];
+	return latency;
+}
+
+std::string
+jsonString(const std::string& s)
+{
+	std::string out{"\""};
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+		}
+		out += c;
+	}
+	out += '"';
+	return out;
+}
+
+void
+writeJSON(std::ostream& out, const Options& options, double outputRate, double internalRate,
+		const StartLatency& startLatency, const std::vector<RunResult>& resultList)
+{
+	out << std::setprecision(9);
+	out << "{\n";
+	out << "  \"config_dir\": " << jsonString(options.configDirPath) << ",\n";
+	out << "  \"workload\": " << jsonString(options.timelineFilePath.empty() ? "sweeps" : options.timelineFilePath) << ",\n";
+	out << "  \"duration\": " << options.duration << ",\n";
+	out << "  \"output_rate\": " << outputRate << ",\n";
+	out << "  \"internal_rate\": " << internalRate << ",\n";
+	out << "  \"start_latency_us\": {\"new_instance\": " << startLatency.newInstance
+		<< ", \"pool\": " << startLatency.pool << "},\n";
+	out << "  \"runs\": [\n";
+	for (std::size_t i = 0; i < resultList.size(); ++i) {
+		const RunResult& r = resultList[i];
+		out << "    {\"threads\": " << r.numThreads
+			<< ", \"wall_time\": " << r.wallTime
+			<< ", \"samples_per_second\": " << r.samplesPerSecond
+			<< ", \"real_time_factor\": " << r.realTimeFactor
+			<< ", \"realtime_voices\": " << r.realtimeVoices
+			<< ", \"scaling_efficiency\": " << r.scalingEfficiency
+			<< ", \"step_latency_us\": {\"p50\": " << r.latencyP50
+			<< ", \"p90\": " << r.latencyP90
+			<< ", \"p99\": " << r.latencyP99
+			<< ", \"max\": " << r.latencyMax << "}}"
+			<< (i + 1U < resultList.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+} /* namespace */
+
+namespace GS {
+namespace VTMBenchmark {
+
+int
+run(int argc, char* argv[])
+{
+	const Options options = parseOptions(argc, argv);
+
+	InteractiveVTMConfiguration configuration{options.configDirPath.c_str()};
+	configuration.setOutputRate(options.outputRate);
+	std::unique_ptr<ConfigurationData> vtmData = configuration.voiceVTMData(0);
+
+	std::unique_ptr<ParameterTimeline> timeline;
+	if (!options.timelineFilePath.empty()) {
+		timeline = std::make_unique<ParameterTimeline>(options.timelineFilePath,
+							configuration.dynamicParamNameList,
+							configuration.dynamicParamMinList,
+							configuration.dynamicParamMaxList);
+	}
+
+	double outputRate; // may be different from the requested rate
+	double internalRate;
+	{
+		std::unique_ptr<VTM::VocalTractModel> vtm = VTM::VocalTractModel::getInstance(*vtmData, true);
+		outputRate = vtm->outputSampleRate();
+		internalRate = vtm->internalSampleRate();
+	}
+	const StartLatency startLatency = measureStartLatency(configuration.voiceVTMDataKey(0, 0), *vtmData);
+
+	// Keeps stdout parseable when it receives the JSON output.
+	std::ostream& tableOut = (options.jsonFilePath == "-") ? std::cerr : std::cout;
+	tableOut << "Internal sample rate: " << internalRate << " Hz\n"
+		<< "Output sample rate: " << outputRate << " Hz\n"
+		<< "Model start latency: " << startLatency.newInstance << " us (new instance), "
+			<< startLatency.pool << " us (pool)\n"
+		<< "Audio duration per thread: " << options.duration << " s\n\n"
+		<< "threads   samples/s       RTF  RT voices  efficiency  p50 (us)  p90 (us)  p99 (us)  max (us)" << std::endl;
+
+	std::vector<RunResult> resultList;
+	for (unsigned int numThreads = 1; numThreads <= options.maxThreads; ++numThreads) {
+		RunResult result = runThreads(numThreads, configuration, *vtmData, timeline.get(), options.duration);
+		if (!resultList.empty()) {
+			result.scalingEfficiency = result.samplesPerSecond / (numThreads * resultList.front().samplesPerSecond);
+		}
+		resultList.push_back(result);
+
+		tableOut << std::fixed << std::setprecision(2)
+			<< std::setw(7) << result.numThreads
+			<< std::setw(12) << std::setprecision(0) << result.samplesPerSecond
+			<< std::setw(10) << std::setprecision(2) << result.realTimeFactor
+			<< std::setw(11) << result.realtimeVoices
+			<< std::setw(12) << result.scalingEfficiency
+			<< std::setw(10) << result.latencyP50
+			<< std::setw(10) << result.latencyP90
+			<< std::setw(10) << result.latencyP99
+			<< std::setw(10) << result.latencyMax << std::endl;
+	}
+
+	if (options.jsonFilePath == "-") {
+		writeJSON(std::cout, options, outputRate, internalRate, startLatency, resultList);
+	} else if (!options.jsonFilePath.empty()) {
+		std::ofstream out(options.jsonFilePath);
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not create the file " << options.jsonFilePath << '.');
+		}
+		writeJSON(out, options, outputRate, internalRate, startLatency, resultList);
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not write to the file " << options.jsonFilePath << '.');
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+} /* namespace VTMBenchmark */
+} /* namespace GS */
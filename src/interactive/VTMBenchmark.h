@@ -1,5 +1,5 @@
 /***************************************************************************
- *  Copyright 2016 Marcelo Y. Matuda                                       *
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
  *                                                                         *
  *  This program is free software: you can redistribute it and/or modify   *
  *  it under the terms of the GNU General Public License as published by   *
@@ -15,70 +15,38 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
  ***************************************************************************/
 
-#include "JackRingbuffer.h"
 
-#include "Exception.h"
+#ifndef VTM_BENCHMARK_H
+#define VTM_BENCHMARK_H
 
 
 
 namespace GS {
 
-struct JackRingbufferException : public virtual Exception {};
-
-JackRingbuffer::JackRingbuffer(size_t ringbufferSize)
-		: ringbuffer_(NULL)
-{
-	ringbuffer_ = jack_ringbuffer_create(ringbufferSize);
-	if (ringbuffer_ == NULL) {
-		THROW_EXCEPTION(JackRingbufferException, "Could not create JACK ringbuffer.");
-	}
-}
-
-JackRingbuffer::~JackRingbuffer()
-{
-	jack_ringbuffer_free(ringbuffer_);
-}
-
-size_t
-JackRingbuffer::readSpace()
-{
-	return jack_ringbuffer_read_space(ringbuffer_);
-}
-
-size_t
-JackRingbuffer::writeSpace()
-{
-	return jack_ringbuffer_write_space(ringbuffer_);
-}
-
-size_t
-JackRingbuffer::read(char* dest, size_t cnt)
-{
-	return jack_ringbuffer_read(ringbuffer_, dest, cnt);
-}
-
-size_t
-JackRingbuffer::write(const char* src, size_t cnt)
-{
-	return jack_ringbuffer_write(ringbuffer_, src, cnt);
-}
-
-size_t
-JackRingbuffer::peek(char* dest, size_t cnt)
-{
-	return jack_ringbuffer_peek(ringbuffer_, dest, cnt);
-}
-
-void
-JackRingbuffer::advanceRead(size_t cnt)
-{
-	jack_ringbuffer_read_advance(ringbuffer_, cnt);
-}
-
-void
-JackRingbuffer::reset()
-{
-	jack_ringbuffer_reset(ringbuffer_);
-}
-
+// Measures the throughput of the interactive vocal tract model.
+//
+// Usage (command line of the editor):
+//
+//     gama_tts_editor --benchmark <interactive config dir> [options]
+//
+// Options:
+//     --threads <n>        maximum number of threads (default: number of cores)
+//     --duration <s>       audio duration rendered by each thread (default: 10)
+//     --output-rate <hz>   output sample rate (default: 44100)
+//     --timeline <file>    parameter timeline (default: built-in sweeps)
+//     --json <file>        writes the results in JSON format ("-": stdout,
+//                          the table is then written to stderr)
+//
+// For each number of threads from 1 to n, each thread renders the same
+// parameter trajectory with its own vocal tract model.
+// The start latency compares creating the model with taking it from a
+// prepared VocalTractModelPool.
+namespace VTMBenchmark {
+
+// Returns the exit status of the program.
+int run(int argc, char* argv[]);
+
+} /* namespace VTMBenchmark */
 } /* namespace GS */
+
+#endif // VTM_BENCHMARK_H
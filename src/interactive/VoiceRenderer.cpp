@@ -0,0 +1,252 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "VoiceRenderer.h"
+
+#include <algorithm> /* fill, min */
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <utility> /* move */
+
+#include "Exception.h"
+#include "VTMUtil.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Constructor.
+ */
+VoiceRenderer::VoiceRenderer(std::size_t numberOfParameters)
+		: numParameters_{numberOfParameters}
+		, lookaheadSamples_{}
+		, sharedParamValues_{std::make_unique<std::atomic<float>[]>(numberOfParameters)}
+		, mixBuffer_(MIX_BUFFER_SIZE)
+		, running_{}
+		, underflowCount_{}
+{
+	for (std::size_t i = 0; i < numParameters_; ++i) {
+		sharedParamValues_[i] = 0.0f;
+	}
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+VoiceRenderer::~VoiceRenderer()
+{
+	stop();
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VoiceRenderer::start(std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList,
+			std::size_t lookaheadSamples, unsigned int numberOfThreads, float parameterFilterPeriod,
+			const ParameterTimeline* timeline)
+{
+	if (lookaheadSamples == 0) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid render lookahead: " << lookaheadSamples << '.');
+	}
+	if (numberOfThreads == 0) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid number of render threads: " << numberOfThreads << '.');
+	}
+
+	stop();
+
+	lookaheadSamples_ = lookaheadSamples;
+	underflowCount_ = 0;
+	for (std::size_t i = 0; i < numParameters_; ++i) {
+		sharedParamValues_[i] = 0.0f;
+	}
+
+	voiceList_.clear();
+	for (auto& vtm : vocalTractModelList) {
+		if (!vtm) {
+			THROW_EXCEPTION(MissingValueException, "Missing vocal tract model.");
+		}
+		auto voice = std::make_unique<Voice>();
+		voice->vtmBufferPos = 0;
+		voice->paramValues.resize(numParameters_);
+		voice->filteredParamValues.resize(numParameters_);
+		voice->paramFilter.reset(numParameters_, vtm->internalSampleRate(), parameterFilterPeriod);
+		voice->timelinePlayer.reset(timeline);
+		voice->timelineStep = 0;
+		voice->audioQueue = std::make_unique<SPSCQueue<float>>(lookaheadSamples_);
+		voice->renderTime = 0;
+		voice->renderedSamples = 0;
+		voice->vocalTractModel = std::move(vtm);
+		voiceList_.push_back(std::move(voice));
+	}
+
+	const std::size_t numThreads = std::min<std::size_t>(numberOfThreads, voiceList_.size());
+	running_ = true;
+	for (std::size_t i = 0; i < numThreads; ++i) {
+		workerList_.emplace_back(&VoiceRenderer::work, this, i, numThreads);
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+std::vector<std::unique_ptr<VTM::VocalTractModel>>
+VoiceRenderer::stop()
+{
+	running_ = false;
+	for (auto& worker : workerList_) {
+		worker.join();
+	}
+	workerList_.clear();
+
+	std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList;
+	for (auto& voice : voiceList_) {
+		vocalTractModelList.push_back(std::move(voice->vocalTractModel));
+	}
+	voiceList_.clear();
+	return vocalTractModelList;
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VoiceRenderer::setParameters(const std::vector<float>& paramValues)
+{
+	const std::size_t n = std::min(paramValues.size(), numParameters_);
+	for (std::size_t i = 0; i < n; ++i) {
+		sharedParamValues_[i].store(paramValues[i], std::memory_order_relaxed);
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+VoiceRenderer::mix(float* out, std::size_t n)
+{
+	std::fill(out, out + n, 0.0f);
+
+	bool underflow = false;
+	for (auto& voice : voiceList_) {
+		for (std::size_t pos = 0; pos < n; ) {
+			const std::size_t blockSize = std::min<std::size_t>(n - pos, MIX_BUFFER_SIZE);
+			const std::size_t numRead = voice->audioQueue->pop(mixBuffer_.data(), blockSize);
+			for (std::size_t i = 0; i < numRead; ++i) {
+				out[pos + i] += mixBuffer_[i];
+			}
+			pos += blockSize;
+			if (numRead < blockSize) {
+				underflow = true;
+				break;
+			}
+		}
+	}
+	if (underflow) ++underflowCount_;
+}
+
+/*******************************************************************************
+ *
+ */
+double
+VoiceRenderer::voiceLoad(std::size_t voice) const
+{
+	if (voice >= voiceList_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid voice: " << voice << '.');
+	}
+	const Voice& v = *voiceList_[voice];
+	const unsigned long long renderedSamples = v.renderedSamples;
+	if (renderedSamples == 0) return 0.0;
+	const double audioTime = renderedSamples / v.vocalTractModel->outputSampleRate();
+	return v.renderTime * 1.0e-9 / audioTime;
+}
+
+/*******************************************************************************
+ * Worker thread.
+ */
+void
+VoiceRenderer::work(std::size_t firstVoice, std::size_t voiceStep)
+{
+	try {
+		while (running_) {
+			bool rendered = false;
+			for (std::size_t i = firstVoice; i < voiceList_.size(); i += voiceStep) {
+				if (renderVoice(*voiceList_[i])) {
+					rendered = true;
+				}
+			}
+			if (!rendered) {
+				std::this_thread::sleep_for(std::chrono::microseconds(WORKER_SLEEP_US));
+			}
+		}
+	} catch (std::exception& exc) {
+		std::cerr << "[VoiceRenderer::work] Caught exception: " << exc.what() << '.' << std::endl;
+	}
+}
+
+/*******************************************************************************
+ * Renders one block of samples, if the audio queue of the voice is not full.
+ *
+ * Returns false if nothing was rendered.
+ */
+bool
+VoiceRenderer::renderVoice(Voice& voice)
+{
+	SPSCQueue<float>& queue = *voice.audioQueue;
+	const std::size_t queuedSamples = queue.capacity() - queue.writeAvailable();
+	if (queuedSamples >= lookaheadSamples_) {
+		return false;
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < numParameters_; ++i) {
+		voice.paramValues[i] = sharedParamValues_[i].load(std::memory_order_relaxed);
+	}
+
+	VTM::VocalTractModel& vtm = *voice.vocalTractModel;
+	std::vector<float>& vtmOutputBuffer = vtm.outputBuffer();
+	const SPSCQueue<float>::View view = queue.writeView(
+			std::min<std::size_t>(lookaheadSamples_ - queuedSamples, RENDER_BLOCK_SIZE));
+	for (const SPSCQueue<float>::Span& span : {view.first, view.second}) {
+		std::size_t pos = 0;
+		while (pos < span.size) {
+			if (vtmOutputBuffer.empty()) {
+				voice.paramFilter.filter(voice.paramValues.data(), voice.filteredParamValues.data());
+				if (voice.timelinePlayer.active()) {
+					voice.timelinePlayer.getValues(voice.timelineStep++ / vtm.internalSampleRate(),
+									voice.filteredParamValues.data());
+				}
+				vtm.setAllParameters(voice.filteredParamValues);
+				vtm.execSynthesisStep();
+				continue;
+			}
+			pos += VTM::Util::getSamples(vtmOutputBuffer, voice.vtmBufferPos, span.data + pos,
+							span.size - pos, 1.0f);
+		}
+	}
+	queue.commitWrite(view.size());
+
+	const auto t1 = std::chrono::steady_clock::now();
+	voice.renderTime += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+	voice.renderedSamples += view.size();
+	return true;
+}
+
+} /* namespace GS */
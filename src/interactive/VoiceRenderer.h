@@ -0,0 +1,102 @@
+/***************************************************************************
+ *  Copyright 2018 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef VOICE_RENDERER_H
+#define VOICE_RENDERER_H
+
+#include <atomic>
+#include <cstddef> /* std::size_t */
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MovingAverageFilterBank.h"
+#include "ParameterTimeline.h"
+#include "SPSCQueue.h"
+#include "VocalTractModel.h"
+
+
+
+namespace GS {
+
+// Renders several vocal tract models (voices) in worker threads, ahead of
+// the JACK callback. All the voices receive the same dynamic parameters.
+class VoiceRenderer {
+public:
+	VoiceRenderer(std::size_t numberOfParameters);
+	~VoiceRenderer();
+
+	// These functions can be called by the main thread only when the JACK thread is not running.
+	// lookaheadSamples: number of samples rendered ahead of the JACK callback, per voice.
+	// parameterFilterPeriod: seconds
+	// timeline: may be null.
+	void start(std::vector<std::unique_ptr<VTM::VocalTractModel>> vocalTractModelList,
+			std::size_t lookaheadSamples, unsigned int numberOfThreads, float parameterFilterPeriod,
+			const ParameterTimeline* timeline);
+	// Returns the vocal tract models.
+	std::vector<std::unique_ptr<VTM::VocalTractModel>> stop();
+
+	// Called only by the JACK thread.
+	void setParameters(const std::vector<float>& paramValues);
+	// Writes the sum of the voices to out.
+	void mix(float* out, std::size_t n);
+
+	// Can be called by any thread.
+	std::size_t numberOfVoices() const { return voiceList_.size(); }
+	// Returns the ratio between the rendering time and the duration of the rendered audio.
+	double voiceLoad(std::size_t voice) const;
+	unsigned int underflowCount() const { return underflowCount_; }
+private:
+	enum {
+		RENDER_BLOCK_SIZE = 128,
+		WORKER_SLEEP_US = 250,
+		MIX_BUFFER_SIZE = 1024
+	};
+
+	struct Voice {
+		std::unique_ptr<VTM::VocalTractModel> vocalTractModel;
+		std::size_t vtmBufferPos;
+		std::vector<float> paramValues;
+		std::vector<float> filteredParamValues;
+		MovingAverageFilterBank paramFilter;
+		ParameterTimeline::Player timelinePlayer;
+		unsigned long timelineStep;
+		std::unique_ptr<SPSCQueue<float>> audioQueue;
+		std::atomic<unsigned long long> renderTime; // ns
+		std::atomic<unsigned long long> renderedSamples;
+	};
+
+	VoiceRenderer(const VoiceRenderer&) = delete;
+	VoiceRenderer& operator=(const VoiceRenderer&) = delete;
+
+	// Called only by the worker threads.
+	void work(std::size_t firstVoice, std::size_t voiceStep);
+	bool renderVoice(Voice& voice);
+
+	std::size_t numParameters_;
+	std::size_t lookaheadSamples_;
+	std::vector<std::unique_ptr<Voice>> voiceList_;
+	std::unique_ptr<std::atomic<float>[]> sharedParamValues_;
+	std::vector<float> mixBuffer_;
+	std::vector<std::thread> workerList_;
+	std::atomic<bool> running_;
+	std::atomic<unsigned int> underflowCount_;
+};
+
+} /* namespace GS */
+
+#endif // VOICE_RENDERER_H
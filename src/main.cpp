@@ -18,14 +18,22 @@
 #include <xmmintrin.h> /* SSE */
 #include <pmmintrin.h> /* SSE3 */
 
+#include <cstring> /* strcmp */
 #include <iostream>
 #include <locale>
 
 #include <QApplication>
+#include <QDir>
 #include <QLocale>
+#include <QStandardPaths>
 
+#include "FFTW.h"
 #include "Log.h"
 #include "MainWindow.h"
+#include "RealtimeLog.h"
+#include "VTMBenchmark.h"
+
+#define FFTW_WISDOM_FILE "fftw_wisdom"
 
 
 
@@ -36,9 +44,16 @@ main(int argc, char* argv[])
 	_MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);         // requires xmmintrin.h
 	_MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON); // requires pmmintrin.h
 
-	GS::Log::debugEnabled = true;
-
 	try {
+		// Command line mode, without GUI.
+		if (argc >= 2 && std::strcmp(argv[1], "--benchmark") == 0) {
+			return GS::VTMBenchmark::run(argc - 2, argv + 2);
+		}
+
+		GS::Log::debugEnabled = true;
+
+		GS::RealtimeLog::DrainThread realtimeLogDrainThread;
+
 		QApplication app(argc, argv);
 
 		QCoreApplication::setOrganizationName("GamaTTS");
@@ -49,10 +64,28 @@ main(int argc, char* argv[])
 		QLocale::setDefault(QLocale::c());
 		std::locale::global(std::locale::classic());
 
+		// Load the FFTW wisdom, to obtain the same plans (and the same
+		// results) as in the previous executions.
+		const QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+		const std::string wisdomFilePath = (configDir + "/" FFTW_WISDOM_FILE).toStdString();
+		if (!configDir.isEmpty()) {
+			GS::FFTW fftw;
+			if (fftw.import_wisdom_from_filename(wisdomFilePath.c_str())) {
+				if (GS::Log::debugEnabled) std::cout << "FFTW wisdom loaded from " << wisdomFilePath << '.' << std::endl;
+			}
+		}
+
 		GS::MainWindow w;
 		w.show();
 		app.exec();
 
+		if (!configDir.isEmpty() && QDir().mkpath(configDir)) {
+			GS::FFTW fftw;
+			if (!fftw.export_wisdom_to_filename(wisdomFilePath.c_str())) {
+				std::cerr << "Could not save the FFTW wisdom to " << wisdomFilePath << '.' << std::endl;
+			}
+		}
+
 		return EXIT_SUCCESS;
 
 	} catch (std::exception& e) {
@@ -25,6 +25,8 @@
 
 #include "qcustomplot.h"
 
+#include <algorithm>
+
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -14460,14 +14462,16 @@ QCPData::QCPData(double key, double value) :
 
 /* start of documentation of inline functions */
 
-/*! \fn QCPDataMap *QCPGraph::data() const
+/* end of documentation of inline functions */
+
+/*! \internal
   
-  Returns a pointer to the internal data storage of type \ref QCPDataMap. You may use it to
-  directly manipulate the data, which may be more convenient and faster than using the regular \ref
-  setData or \ref addData methods, in certain situations.
+  Compares the keys of two data points. Used with the sorted data of QCPGraph.
 */
-
-/* end of documentation of inline functions */
+static bool qcpDataKeyLessThan(const QCPData &a, const QCPData &b)
+{
+  return a.key < b.key;
+}
 
 /*!
   Constructs a graph which uses \a keyAxis as its key axis ("x") and \a valueAxis as its value
@@ -14481,7 +14485,8 @@ QCPData::QCPData(double key, double value) :
   To directly create a graph inside a plot, you can also use the simpler QCustomPlot::addGraph function.
 */
 QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-  QCPAbstractPlottable(keyAxis, valueAxis)
+  QCPAbstractPlottable(keyAxis, valueAxis),
+  mSortedDataEnabled(false)
 {
   mData = new QCPDataMap;
   
@@ -14504,6 +14509,20 @@ QCPGraph::~QCPGraph()
   delete mData;
 }
 
+/*!
+  Returns a pointer to the internal data storage of type \ref QCPDataMap. You may use it to
+  directly manipulate the data, which may be more convenient and faster than using the regular \ref
+  setData or \ref addData methods, in certain situations.
+  
+  If the graph uses sorted data (see \ref setSortedData), the data is moved to the map first, and
+  the graph uses the map from then on.
+*/
+QCPDataMap *QCPGraph::data() const
+{
+  moveSortedDataToMap();
+  return mData;
+}
+
 /*!
   Replaces the current data with the provided \a data.
   
@@ -14521,6 +14540,7 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
     qDebug() << Q_FUNC_INFO << "The data pointer is already in (and owned by) this plottable" << reinterpret_cast<quintptr>(data);
     return;
   }
+  clearSortedData();
   if (copy)
   {
     *mData = *data;
@@ -14539,6 +14559,7 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
 */
 void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14551,6 +14572,39 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
   }
 }
 
+/*! \overload
+  
+  Replaces the current data with the provided points in \a key and \a value pairs, and stores them
+  in a contiguous vector instead of the \ref QCPDataMap. No memory is allocated if the new data is
+  not bigger than the previous one. The visible range is found by binary search.
+  
+  The keys should be sorted in ascending order. If they are not, they are sorted here.
+  
+  The data can be accessed with \ref sortedData. Functions that modify the data map (e.g. \ref
+  addData, \ref removeData and \ref data) move the data to the map first.
+*/
+void QCPGraph::setSortedData(const QVector<double> &key, const QVector<double> &value)
+{
+  mData->clear();
+  int n = key.size();
+  n = qMin(n, value.size());
+  mSortedData.resize(n);
+  bool sorted = true;
+  for (int i=0; i<n; ++i)
+  {
+    QCPData &data = mSortedData[i];
+    data.key = key[i];
+    data.value = value[i];
+    data.keyErrorPlus = data.keyErrorMinus = 0;
+    data.valueErrorPlus = data.valueErrorMinus = 0;
+    if (i > 0 && data.key < mSortedData[i-1].key)
+      sorted = false;
+  }
+  if (!sorted)
+    std::stable_sort(mSortedData.begin(), mSortedData.end(), qcpDataKeyLessThan);
+  mSortedDataEnabled = true;
+}
+
 /*!
   Replaces the current data with the provided points in \a key and \a value pairs. Additionally the
   symmetrical value error of the data points are set to the values in \a valueError.
@@ -14562,6 +14616,7 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14588,6 +14643,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14615,6 +14671,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14641,6 +14698,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14668,6 +14726,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError, const QVector<double> &valueError)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14697,6 +14756,7 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
+  clearSortedData();
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
@@ -14861,6 +14921,7 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
 */
 void QCPGraph::addData(const QCPDataMap &dataMap)
 {
+  moveSortedDataToMap();
   mData->unite(dataMap);
 }
 
@@ -14874,6 +14935,7 @@ void QCPGraph::addData(const QCPDataMap &dataMap)
 */
 void QCPGraph::addData(const QCPData &data)
 {
+  moveSortedDataToMap();
   mData->insertMulti(data.key, data);
 }
 
@@ -14887,6 +14949,7 @@ void QCPGraph::addData(const QCPData &data)
 */
 void QCPGraph::addData(double key, double value)
 {
+  moveSortedDataToMap();
   QCPData newData;
   newData.key = key;
   newData.value = value;
@@ -14903,6 +14966,7 @@ void QCPGraph::addData(double key, double value)
 */
 void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &values)
 {
+  moveSortedDataToMap();
   int n = qMin(keys.size(), values.size());
   QCPData newData;
   for (int i=0; i<n; ++i)
@@ -14919,6 +14983,7 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
 */
 void QCPGraph::removeDataBefore(double key)
 {
+  moveSortedDataToMap();
   QCPDataMap::iterator it = mData->begin();
   while (it != mData->end() && it.key() < key)
     it = mData->erase(it);
@@ -14930,6 +14995,7 @@ void QCPGraph::removeDataBefore(double key)
 */
 void QCPGraph::removeDataAfter(double key)
 {
+  moveSortedDataToMap();
   if (mData->isEmpty()) return;
   QCPDataMap::iterator it = mData->upperBound(key);
   while (it != mData->end())
@@ -14945,6 +15011,7 @@ void QCPGraph::removeDataAfter(double key)
 */
 void QCPGraph::removeData(double fromKey, double toKey)
 {
+  moveSortedDataToMap();
   if (fromKey >= toKey || mData->isEmpty()) return;
   QCPDataMap::iterator it = mData->upperBound(fromKey);
   QCPDataMap::iterator itEnd = mData->upperBound(toKey);
@@ -14962,6 +15029,7 @@ void QCPGraph::removeData(double fromKey, double toKey)
 */
 void QCPGraph::removeData(double key)
 {
+  moveSortedDataToMap();
   mData->remove(key);
 }
 
@@ -14971,6 +15039,7 @@ void QCPGraph::removeData(double key)
 */
 void QCPGraph::clearData()
 {
+  clearSortedData();
   mData->clear();
 }
 
@@ -14978,7 +15047,7 @@ void QCPGraph::clearData()
 double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
 {
   Q_UNUSED(details)
-  if ((onlySelectable && !mSelectable) || mData->isEmpty())
+  if ((onlySelectable && !mSelectable) || isDataEmpty())
     return -1;
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return -1; }
   
@@ -15012,7 +15081,7 @@ void QCPGraph::rescaleKeyAxis(bool onlyEnlarge, bool includeErrorBars) const
 {
   // this code is a copy of QCPAbstractPlottable::rescaleKeyAxis with the only change
   // that getKeyRange is passed the includeErrorBars value.
-  if (mData->isEmpty()) return;
+  if (isDataEmpty()) return;
   
   QCPAxis *keyAxis = mKeyAxis.data();
   if (!keyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
@@ -15048,7 +15117,7 @@ void QCPGraph::rescaleValueAxis(bool onlyEnlarge, bool includeErrorBars) const
 {
   // this code is a copy of QCPAbstractPlottable::rescaleValueAxis with the only change
   // is that getValueRange is passed the includeErrorBars value.
-  if (mData->isEmpty()) return;
+  if (isDataEmpty()) return;
   
   QCPAxis *valueAxis = mValueAxis.data();
   if (!valueAxis) { qDebug() << Q_FUNC_INFO << "invalid value axis"; return; }
@@ -15077,7 +15146,7 @@ void QCPGraph::rescaleValueAxis(bool onlyEnlarge, bool includeErrorBars) const
 void QCPGraph::draw(QCPPainter *painter)
 {
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  if (mKeyAxis.data()->range().size() <= 0 || mData->isEmpty()) return;
+  if (mKeyAxis.data()->range().size() <= 0 || isDataEmpty()) return;
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
   // allocate line and (if necessary) point vectors:
@@ -15659,15 +15728,36 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData)
   This method is used by the various "get(...)PlotData" methods to get the basic working set of data.
 */
 void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const
+{
+  if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  // get visible data range:
+  if (mSortedDataEnabled)
+  {
+    QCPSortedDataIterator lower, upper; // note that upper is the actual upper point, and not 1 step after the upper point
+    getVisibleDataBounds(lower, upper);
+    if (lower == sortedDataEnd() || upper == sortedDataEnd())
+      return;
+    getPreparedDataInBounds(lower, upper, lineData, scatterData);
+  } else
+  {
+    QCPDataMap::const_iterator lower, upper; // note that upper is the actual upper point, and not 1 step after the upper point
+    getVisibleDataBounds(lower, upper);
+    if (lower == mData->constEnd() || upper == mData->constEnd())
+      return;
+    getPreparedDataInBounds(lower, upper, lineData, scatterData);
+  }
+}
+
+/*! \internal
+  
+  Implementation of \ref getPreparedData for the data points between \a lower and \a upper
+  (including them), for both the data map and the sorted data.
+*/
+template <class DataIterator>
+void QCPGraph::getPreparedDataInBounds(const DataIterator &lower, const DataIterator &upper, QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
-  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  // get visible data range:
-  QCPDataMap::const_iterator lower, upper; // note that upper is the actual upper point, and not 1 step after the upper point
-  getVisibleDataBounds(lower, upper);
-  if (lower == mData->constEnd() || upper == mData->constEnd())
-    return;
   
   // count points in visible range, taking into account that we only need to count to the limit maxCount if using adaptive sampling:
   int maxCount = std::numeric_limits<int>::max();
@@ -15682,11 +15772,11 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
   {
     if (lineData)
     {
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
+      DataIterator it = lower;
+      DataIterator upperEnd = upper+1;
       double minValue = it.value().value;
       double maxValue = it.value().value;
-      QCPDataMap::const_iterator currentIntervalFirstPoint = it;
+      DataIterator currentIntervalFirstPoint = it;
       int reversedFactor = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? -1 : 1; // is used to calculate keyEpsilon pixel into the correct direction
       int reversedRound = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
       double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
@@ -15742,13 +15832,13 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
     {
       double valueMaxRange = valueAxis->range().upper;
       double valueMinRange = valueAxis->range().lower;
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
+      DataIterator it = lower;
+      DataIterator upperEnd = upper+1;
       double minValue = it.value().value;
       double maxValue = it.value().value;
-      QCPDataMap::const_iterator minValueIt = it;
-      QCPDataMap::const_iterator maxValueIt = it;
-      QCPDataMap::const_iterator currentIntervalStart = it;
+      DataIterator minValueIt = it;
+      DataIterator maxValueIt = it;
+      DataIterator currentIntervalStart = it;
       int reversedFactor = keyAxis->rangeReversed() ? -1 : 1; // is used to calculate keyEpsilon pixel into the correct direction
       int reversedRound = keyAxis->rangeReversed() ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
       double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
@@ -15777,7 +15867,7 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
             // determine value pixel span and add as many points in interval to maintain certain vertical data density (this is specific to scatter plot):
             double valuePixelSpan = qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue));
             int dataModulo = qMax(1, qRound(intervalDataCount/(valuePixelSpan/4.0))); // approximately every 4 value pixels one data point on average
-            QCPDataMap::const_iterator intervalIt = currentIntervalStart;
+            DataIterator intervalIt = currentIntervalStart;
             int c = 0;
             while (intervalIt != it)
             {
@@ -15804,7 +15894,7 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
         // determine value pixel span and add as many points in interval to maintain certain vertical data density (this is specific to scatter plot):
         double valuePixelSpan = qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue));
         int dataModulo = qMax(1, qRound(intervalDataCount/(valuePixelSpan/4.0))); // approximately every 4 value pixels one data point on average
-        QCPDataMap::const_iterator intervalIt = currentIntervalStart;
+        DataIterator intervalIt = currentIntervalStart;
         int c = 0;
         while (intervalIt != it)
         {
@@ -15825,8 +15915,8 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
       dataVector = scatterData;
     if (dataVector)
     {
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
+      DataIterator it = lower;
+      DataIterator upperEnd = upper+1;
       dataVector->reserve(dataCount+2); // +2 for possible fill end points
       while (it != upperEnd)
       {
@@ -15977,6 +16067,31 @@ void QCPGraph::getVisibleDataBounds(QCPDataMap::const_iterator &lower, QCPDataMa
   upper = (highoutlier ? ubound : ubound-1); // data point range that will be actually drawn
 }
 
+/*! \internal \overload
+  
+  Version of \ref getVisibleDataBounds for the sorted data. Uses binary search.
+*/
+void QCPGraph::getVisibleDataBounds(QCPSortedDataIterator &lower, QCPSortedDataIterator &upper) const
+{
+  if (!mKeyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
+  if (mSortedData.isEmpty())
+  {
+    lower = sortedDataEnd();
+    upper = sortedDataEnd();
+    return;
+  }
+  
+  const QCPData *begin = mSortedData.constData();
+  const QCPData *end = begin+mSortedData.size();
+  const QCPData *lbound = std::lower_bound(begin, end, QCPData(mKeyAxis.data()->range().lower, 0), qcpDataKeyLessThan);
+  const QCPData *ubound = std::upper_bound(begin, end, QCPData(mKeyAxis.data()->range().upper, 0), qcpDataKeyLessThan);
+  bool lowoutlier = lbound != begin; // indicates whether there exist points below axis range
+  bool highoutlier = ubound != end; // indicates whether there exist points above axis range
+  
+  lower = QCPSortedDataIterator(lowoutlier ? lbound-1 : lbound); // data point range that will be actually drawn
+  upper = QCPSortedDataIterator(highoutlier ? ubound : ubound-1); // data point range that will be actually drawn
+}
+
 /*!  \internal
   
   Counts the number of data points between \a lower and \a upper (including them), up to a maximum
@@ -16001,6 +16116,51 @@ int QCPGraph::countDataInBounds(const QCPDataMap::const_iterator &lower, const Q
   return count;
 }
 
+/*! \internal \overload
+  
+  Version of \ref countDataInBounds for the sorted data. Doesn't need to iterate.
+*/
+int QCPGraph::countDataInBounds(const QCPSortedDataIterator &lower, const QCPSortedDataIterator &upper, int maxCount) const
+{
+  if (upper == sortedDataEnd() && lower == sortedDataEnd())
+    return 0;
+  return qMin(static_cast<int>(upper.ptr()-lower.ptr())+1, maxCount);
+}
+
+/*! \internal
+  
+  Returns true if the graph has no data points, in the data map or in the sorted data.
+*/
+bool QCPGraph::isDataEmpty() const
+{
+  return mSortedDataEnabled ? mSortedData.isEmpty() : mData->isEmpty();
+}
+
+/*! \internal
+  
+  Disables the sorted data. The vector keeps its memory.
+*/
+void QCPGraph::clearSortedData()
+{
+  mSortedData.resize(0);
+  mSortedDataEnabled = false;
+}
+
+/*! \internal
+  
+  If the graph uses sorted data, moves it to the data map.
+*/
+void QCPGraph::moveSortedDataToMap() const
+{
+  if (!mSortedDataEnabled)
+    return;
+  mData->clear();
+  for (int i=0; i<mSortedData.size(); ++i)
+    mData->insertMulti(mSortedData.at(i).key, mSortedData.at(i));
+  mSortedData.resize(0);
+  mSortedDataEnabled = false;
+}
+
 /*! \internal
   
   The line data vector generated by e.g. getLinePlotData contains only the line that connects the
@@ -16399,7 +16559,7 @@ int QCPGraph::findIndexAboveY(const QVector<QPointF> *data, double y) const
 */
 double QCPGraph::pointDistance(const QPointF &pixelPoint) const
 {
-  if (mData->isEmpty())
+  if (isDataEmpty())
     return -1.0;
   if (mLineStyle == lsNone && mScatterStyle.isNone())
     return -1.0;
@@ -16504,6 +16664,20 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain) cons
   \see getKeyRange(bool &foundRange, SignDomain inSignDomain)
 */
 QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
+{
+  if (mSortedDataEnabled)
+    return getKeyRangeInBounds(sortedDataBegin(), sortedDataEnd(), foundRange, inSignDomain, includeErrors);
+  else
+    return getKeyRangeInBounds(mData->constBegin(), mData->constEnd(), foundRange, inSignDomain, includeErrors);
+}
+
+/*! \internal
+  
+  Implementation of \ref getKeyRange for the data points in [\a begin, \a end), for both the data
+  map and the sorted data.
+*/
+template <class DataIterator>
+QCPRange QCPGraph::getKeyRangeInBounds(const DataIterator &begin, const DataIterator &end, bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
 {
   QCPRange range;
   bool haveLower = false;
@@ -16513,8 +16687,8 @@ QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool i
   
   if (inSignDomain == sdBoth) // range may be anywhere
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       if (!qIsNaN(it.value().value))
       {
@@ -16536,8 +16710,8 @@ QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool i
     }
   } else if (inSignDomain == sdNegative) // range may only be in the negative sign domain
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       if (!qIsNaN(it.value().value))
       {
@@ -16572,8 +16746,8 @@ QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool i
     }
   } else if (inSignDomain == sdPositive) // range may only be in the positive sign domain
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       if (!qIsNaN(it.value().value))
       {
@@ -16619,6 +16793,20 @@ QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool i
   \see getValueRange(bool &foundRange, SignDomain inSignDomain)
 */
 QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
+{
+  if (mSortedDataEnabled)
+    return getValueRangeInBounds(sortedDataBegin(), sortedDataEnd(), foundRange, inSignDomain, includeErrors);
+  else
+    return getValueRangeInBounds(mData->constBegin(), mData->constEnd(), foundRange, inSignDomain, includeErrors);
+}
+
+/*! \internal
+  
+  Implementation of \ref getValueRange for the data points in [\a begin, \a end), for both the data
+  map and the sorted data.
+*/
+template <class DataIterator>
+QCPRange QCPGraph::getValueRangeInBounds(const DataIterator &begin, const DataIterator &end, bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
 {
   QCPRange range;
   bool haveLower = false;
@@ -16628,8 +16816,8 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain, bool
   
   if (inSignDomain == sdBoth) // range may be anywhere
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       current = it.value().value;
       if (!qIsNaN(current))
@@ -16651,8 +16839,8 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain, bool
     }
   } else if (inSignDomain == sdNegative) // range may only be in the negative sign domain
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       current = it.value().value;
       if (!qIsNaN(current))
@@ -16687,8 +16875,8 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain, bool
     }
   } else if (inSignDomain == sdPositive) // range may only be in the positive sign domain
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    DataIterator it = begin;
+    while (it != end)
     {
       current = it.value().value;
       if (!qIsNaN(current))
@@ -2486,6 +2486,29 @@ typedef QMap<double, QCPData> QCPDataMap;
 typedef QMapIterator<double, QCPData> QCPDataMapIterator;
 typedef QMutableMapIterator<double, QCPData> QCPDataMutableMapIterator;
 
+/*! \class QCPSortedDataIterator
+  Const iterator over the contiguous data of a QCPGraph (see \ref QCPGraph::setSortedData). It
+  has the same interface as QCPDataMap::const_iterator, so the same algorithms can be used with
+  both containers.
+*/
+class QCPSortedDataIterator
+{
+public:
+  QCPSortedDataIterator() : mPtr(0) {}
+  explicit QCPSortedDataIterator(const QCPData *ptr) : mPtr(ptr) {}
+  double key() const { return mPtr->key; }
+  const QCPData &value() const { return *mPtr; }
+  const QCPData *ptr() const { return mPtr; }
+  QCPSortedDataIterator &operator++() { ++mPtr; return *this; }
+  QCPSortedDataIterator &operator--() { --mPtr; return *this; }
+  QCPSortedDataIterator operator+(int n) const { return QCPSortedDataIterator(mPtr+n); }
+  QCPSortedDataIterator operator-(int n) const { return QCPSortedDataIterator(mPtr-n); }
+  bool operator==(const QCPSortedDataIterator &other) const { return mPtr == other.mPtr; }
+  bool operator!=(const QCPSortedDataIterator &other) const { return mPtr != other.mPtr; }
+private:
+  const QCPData *mPtr;
+};
+
 
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
 {
@@ -2529,7 +2552,10 @@ public:
   virtual ~QCPGraph();
   
   // getters:
-  QCPDataMap *data() const { return mData; }
+  QCPDataMap *data() const;
+  bool hasSortedData() const { return mSortedDataEnabled; }
+  const QVector<QCPData> &sortedData() const { return mSortedData; }
+  QVector<QCPData> *sortedData() { return &mSortedData; }
   LineStyle lineStyle() const { return mLineStyle; }
   QCPScatterStyle scatterStyle() const { return mScatterStyle; }
   ErrorType errorType() const { return mErrorType; }
@@ -2542,6 +2568,7 @@ public:
   // setters:
   void setData(QCPDataMap *data, bool copy=false);
   void setData(const QVector<double> &key, const QVector<double> &value);
+  void setSortedData(const QVector<double> &key, const QVector<double> &value);
   void setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError);
   void setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus);
   void setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError);
@@ -2580,6 +2607,8 @@ public:
 protected:
   // property members:
   QCPDataMap *mData;
+  mutable QVector<QCPData> mSortedData;
+  mutable bool mSortedDataEnabled;
   QPen mErrorPen;
   LineStyle mLineStyle;
   QCPScatterStyle mScatterStyle;
@@ -2614,7 +2643,17 @@ protected:
   void getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
   void drawError(QCPPainter *painter, double x, double y, const QCPData &data) const;
   void getVisibleDataBounds(QCPDataMap::const_iterator &lower, QCPDataMap::const_iterator &upper) const;
+  void getVisibleDataBounds(QCPSortedDataIterator &lower, QCPSortedDataIterator &upper) const;
   int countDataInBounds(const QCPDataMap::const_iterator &lower, const QCPDataMap::const_iterator &upper, int maxCount) const;
+  int countDataInBounds(const QCPSortedDataIterator &lower, const QCPSortedDataIterator &upper, int maxCount) const;
+  template <class DataIterator> void getPreparedDataInBounds(const DataIterator &lower, const DataIterator &upper, QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const;
+  template <class DataIterator> QCPRange getKeyRangeInBounds(const DataIterator &begin, const DataIterator &end, bool &foundRange, SignDomain inSignDomain, bool includeErrors) const;
+  template <class DataIterator> QCPRange getValueRangeInBounds(const DataIterator &begin, const DataIterator &end, bool &foundRange, SignDomain inSignDomain, bool includeErrors) const;
+  bool isDataEmpty() const;
+  void clearSortedData();
+  void moveSortedDataToMap() const;
+  QCPSortedDataIterator sortedDataBegin() const { return QCPSortedDataIterator(mSortedData.constData()); }
+  QCPSortedDataIterator sortedDataEnd() const { return QCPSortedDataIterator(mSortedData.constData()+mSortedData.size()); }
   void addFillBasePoints(QVector<QPointF> *lineData) const;
   void removeFillBasePoints(QVector<QPointF> *lineData) const;
   QPointF lowerFillBasePoint(double lowerKey) const;